@@ -8,9 +8,93 @@ ENUM_CONVERSION_BEGIN(Plugin::Launcher::mode)
     { Plugin::Launcher::mode::RELATIVE, _TXT("relative") },
     { Plugin::Launcher::mode::ABSOLUTE, _TXT("absolute") },
     { Plugin::Launcher::mode::ABSOLUTE_WITH_INTERVAL, _TXT("interval") },
+    { Plugin::Launcher::mode::CRON, _TXT("cron") },
 
 ENUM_CONVERSION_END(Plugin::Launcher::mode)
 
+ENUM_CONVERSION_BEGIN(Plugin::Launcher::backend)
+
+    { Plugin::Launcher::backend::NETLINK, _TXT("netlink") },
+    { Plugin::Launcher::backend::PIDFD, _TXT("pidfd") },
+
+ENUM_CONVERSION_END(Plugin::Launcher::backend)
+
+ENUM_CONVERSION_BEGIN(Plugin::Launcher::accounting)
+
+    { Plugin::Launcher::accounting::STATM, _TXT("statm") },
+    { Plugin::Launcher::accounting::PROPORTIONAL, _TXT("pss") },
+
+ENUM_CONVERSION_END(Plugin::Launcher::accounting)
+
+ENUM_CONVERSION_BEGIN(Plugin::Launcher::order)
+
+    { Plugin::Launcher::order::FIFO, _TXT("fifo") },
+    { Plugin::Launcher::order::PRIORITY, _TXT("priority") },
+
+ENUM_CONVERSION_END(Plugin::Launcher::order)
+
+ENUM_CONVERSION_BEGIN(Plugin::Launcher::catchup)
+
+    { Plugin::Launcher::catchup::SKIP, _TXT("skip") },
+    { Plugin::Launcher::catchup::ONCE, _TXT("once") },
+    { Plugin::Launcher::catchup::ALL, _TXT("all") },
+
+ENUM_CONVERSION_END(Plugin::Launcher::catchup)
+
+ENUM_CONVERSION_BEGIN(Plugin::Launcher::overlap)
+
+    { Plugin::Launcher::overlap::DISCARD, _TXT("skip") },
+    { Plugin::Launcher::overlap::QUEUE, _TXT("queue") },
+    { Plugin::Launcher::overlap::CONCURRENT, _TXT("concurrent") },
+    { Plugin::Launcher::overlap::RESTART, _TXT("restart") },
+
+ENUM_CONVERSION_END(Plugin::Launcher::overlap)
+
+ENUM_CONVERSION_BEGIN(Plugin::Launcher::termination)
+
+    { Plugin::Launcher::termination::HANGUP, _TXT("SIGHUP") },
+    { Plugin::Launcher::termination::INTERRUPT, _TXT("SIGINT") },
+    { Plugin::Launcher::termination::QUIT, _TXT("SIGQUIT") },
+    { Plugin::Launcher::termination::TERMINATE, _TXT("SIGTERM") },
+    { Plugin::Launcher::termination::KILL, _TXT("SIGKILL") },
+    { Plugin::Launcher::termination::USER1, _TXT("SIGUSR1") },
+    { Plugin::Launcher::termination::USER2, _TXT("SIGUSR2") },
+
+ENUM_CONVERSION_END(Plugin::Launcher::termination)
+
+ENUM_CONVERSION_BEGIN(Plugin::Launcher::target)
+
+    { Plugin::Launcher::target::ROOT, _TXT("root") },
+    { Plugin::Launcher::target::GROUP, _TXT("group") },
+    { Plugin::Launcher::target::TREE, _TXT("tree") },
+
+ENUM_CONVERSION_END(Plugin::Launcher::target)
+
+ENUM_CONVERSION_BEGIN(Plugin::Launcher::supervision)
+
+    { Plugin::Launcher::supervision::NEVER, _TXT("never") },
+    { Plugin::Launcher::supervision::ON_FAILURE, _TXT("on-failure") },
+    { Plugin::Launcher::supervision::ALWAYS, _TXT("always") },
+
+ENUM_CONVERSION_END(Plugin::Launcher::supervision)
+
+ENUM_CONVERSION_BEGIN(Plugin::Launcher::policy)
+
+    { Plugin::Launcher::policy::OTHER, _TXT("other") },
+    { Plugin::Launcher::policy::BATCH, _TXT("batch") },
+    { Plugin::Launcher::policy::IDLE, _TXT("idle") },
+
+ENUM_CONVERSION_END(Plugin::Launcher::policy)
+
+ENUM_CONVERSION_BEGIN(Plugin::Launcher::ioclass)
+
+    { Plugin::Launcher::ioclass::IO_NONE, _TXT("none") },
+    { Plugin::Launcher::ioclass::IO_REALTIME, _TXT("realtime") },
+    { Plugin::Launcher::ioclass::IO_BESTEFFORT, _TXT("best-effort") },
+    { Plugin::Launcher::ioclass::IO_IDLE, _TXT("idle") },
+
+ENUM_CONVERSION_END(Plugin::Launcher::ioclass)
+
 namespace Plugin {
 
     namespace {
@@ -27,40 +111,118 @@ namespace Plugin {
         );
     }
 
-/* static */ Launcher::ProcessObserver Launcher::_observer;
+/* static */ Launcher::ProcessObserver Launcher::_netlinkObserver(Launcher::NETLINK);
+/* static */ Launcher::ProcessObserver Launcher::_pidfdObserver(Launcher::PIDFD);
 
 /* virtual */ const string Launcher::Initialize(PluginHost::IShell* service)
 {
-    Core::Time scheduleTime;
-    Time interval;
+    std::vector<Plan> schedules;
     string message;
     Config config;
 
     ASSERT(_service == nullptr);
     ASSERT(_memory == nullptr);
-    ASSERT(_activity.IsValid() == false);
+    ASSERT(_activities.empty() == true);
 
     // Setup skip URL for right offset.
     config.FromString(service->ConfigLine());
 
-    if ((config.Command.IsSet() == false) || (config.Command.Value().empty() == true)) {
+    // A single command is just a list with one entry, the configuration itself is that entry.
+    if ((config.Command.IsSet() == true) && (config.Command.Value().empty() == false)) {
+        config.Commands.Add().FromString(service->ConfigLine());
+    }
+
+    auto index = config.Commands.Elements();
+
+    while ((message.empty() == true) && (index.Next() == true)) {
+        Plan plan;
+
+        if ((index.Current().Command.IsSet() == false) || (index.Current().Command.Value().empty() == true)) {
+            message = _T("Command is not set");
+        }
+        else if ((ScheduleParameters(index.Current().ScheduleTime, message, plan) == true) && (ResourceParameters(index.Current().Limits, message, plan) == true)) {
+            schedules.push_back(plan);
+        }
+    }
+
+    if ((message.empty() == true) && (schedules.empty() == true)) {
         message = _T("Command is not set");
     }
-    else if (ScheduleParameters(config, message, scheduleTime, interval) == true) {
+    else if (message.empty() == true) {
         _service = service;
         _service->AddRef();
         _deactivationInProgress = false;
 
-        _memory = Core::ServiceType<MemoryObserverImpl>::Create<Exchange::IMemory>(0);
+        _memory = Core::ServiceType<MemoryObserverImpl>::Create<MemoryObserverImpl>();
         ASSERT(_memory != nullptr);
 
-        _activity = Core::ProxyType<Job>::Create(&config, interval, _memory);
-        ASSERT (_activity.IsValid() == true);
+        string group;
 
-        // Well if we where able to parse the parameters (if needed) we are ready to start it..
-        _observer.Register(&_notification);
+        if ((config.CGroup.IsSet() == true) && (config.CGroup.Value().empty() == false)) {
+            // Each instance gets its own leaf, the processes are contained in there, no need to observe them.
+            group = config.CGroup.Value() + '/' + service->Callsign();
+        }
+        else {
+            _observer = (config.Observer.Value() == PIDFD ? &_pidfdObserver : &_netlinkObserver);
+        }
+
+        if (config.Zygote.Value() == true) {
+            _zygote.reset(new Zygote(_T(LAUNCHER_ZYGOTE)));
+
+            if (_zygote->Open() != Core::ERROR_NONE) {
+                message = _T("Could not start the zygote: ") + string(_T(LAUNCHER_ZYGOTE));
+            }
+        }
+
+        _pool.Open(config.Parallelism.Value(), config.Queue.Value());
+
+        if (_gate.Open(config.Gate.Cpu.Value(), config.Gate.Memory.Value(), config.Gate.Io.Value(), config.Gate.MaxDelay.Value()) != Core::ERROR_NONE) {
+            // Not worth failing for, it only holds back the launches.
+            SYSLOG(Logging::Notification, (_T("No pressure stall information available, %s launches regardless of the pressure."), service->Callsign().c_str()));
+        }
+
+        const Context context { config, _pool, _wheel, _gate, _memory, _zygote.get(), _observer, &_notification };
+
+        index.Reset();
+
+        while ((message.empty() == true) && (index.Next() == true)) {
+            // With more commands, each of them gets a leaf of its own.
+            const string leaf(group.empty() || (schedules.size() == 1) ? group : group + '.' + Core::NumberType<uint32_t>(static_cast<uint32_t>(_activities.size())).Text());
+
+            Core::ProxyType<Job> activity(Core::ProxyType<Job>::Create(context, index.Current(), schedules[_activities.size()], leaf));
+            ASSERT (activity.IsValid() == true);
+
+            const uint32_t result = activity->Open();
+
+            if (result == Core::ERROR_OPENING_FAILED) {
+                message = _T("Could not capture the output of: ") + activity->Command();
+            }
+            else if (result == Core::ERROR_BAD_REQUEST) {
+                message = _T("Could not limit control group: ") + leaf;
+            }
+            else if (result != Core::ERROR_NONE) {
+                message = _T("Could not create control group: ") + leaf;
+            }
+            else {
+                _activities.push_back(activity);
+            }
+        }
+
+        if (message.empty() == false) {
+            Cleanup();
+        }
+        else {
+            // Well if we where able to parse the parameters (if needed) we are ready to start it..
+            if (_observer != nullptr) {
+                _observer->Register(&_notification);
+            }
+
+            _memory->Configure(config.MemoryUsage.Accounting.Value(), config.MemoryUsage.Period.Value());
 
-        _activity->Schedule(scheduleTime);
+            for (uint32_t entry = 0; entry < _activities.size(); entry++) {
+                _activities[entry]->Schedule(schedules[entry].Start);
+            }
+        }
     }
 
     return (message);
@@ -70,82 +232,218 @@ namespace Plugin {
 {
     if (_service != nullptr) {
         ASSERT(_memory != nullptr);
-        ASSERT(_activity.IsValid() == true);
+        ASSERT(_activities.empty() == false);
 
         _deactivationInProgress = true;
 
-        _activity->Shutdown();
-        _observer.Unregister(&_notification);
-        _activity.Release();
+        // Nothing queued may start anymore.
+        _pool.Close();
+
+        Core::Time deadline;
 
-        _memory->Release();
-        _memory = nullptr;
-        _service->Release();
-        _service = nullptr;
+        // All of them are stopped at the same time, so stopping them takes as long as the slowest. This
+        // still blocks till they are gone, the code that handles their exits can not be unloaded before.
+        for (Core::ProxyType<Job>& activity : _activities) {
+            const Core::Time completed(activity->Terminate());
+
+            if (completed > deadline) {
+                deadline = completed;
+            }
+        }
+        for (Core::ProxyType<Job>& activity : _activities) {
+            activity->Wait(deadline);
+        }
+        if (_observer != nullptr) {
+            _observer->Unregister(&_notification);
+        }
+
+        Cleanup();
     }
 }
 
+void Launcher::Cleanup()
+{
+    Activities activities;
+
+    _pool.Close();
+    _wheel.Close();
+    _gate.Close();
+
+    // Stop the reports of the control groups first, a report in progress is completed before
+    // the group is closed. Not under the lock, that report takes it.
+    for (Core::ProxyType<Job>& activity : _activities) {
+        activity->Close();
+    }
+
+    // The status can be asked for at any time.
+    _adminLock.Lock();
+    activities.swap(_activities);
+    _adminLock.Unlock();
+
+    for (Core::ProxyType<Job>& activity : activities) {
+        activity.Release();
+    }
+    _zygote.reset();
+    _observer = nullptr;
+
+    _memory->Stop();
+    _memory->Release();
+    _memory = nullptr;
+    _service->Release();
+    _service = nullptr;
+}
+
 /* virtual */ string Launcher::Information() const
 {
-    // No additional info to report.
-    return (string());
+    Statistics statistics;
+    string result;
+
+    Status(statistics);
+    statistics.ToString(result);
+
+    return (result);
+}
+
+void Launcher::Status(Statistics& statistics) const
+{
+    _adminLock.Lock();
+
+    statistics.LostEvents = (_observer != nullptr ? _observer->Lost() : 0);
+
+    for (const Core::ProxyType<Job>& activity : _activities) {
+        activity->Report(statistics.Activities.Add());
+    }
+
+    _adminLock.Unlock();
 }
 
 void Launcher::Update(const ProcessObserver::Info& info)
 {
-    // There is always an Activity as the unregister takes place in a locked sequence. So no new notifications
-    // Will enter after the unregister of this handler.
-    ASSERT (_activity.IsValid() == true);
-    ASSERT(_service != nullptr);
-
-    // This can potentially be called on a socket thread, so the deactivation (wich in turn kills this object) must be done
-    // on a seperate thread. Also make sure this call-stack can be unwound before we are totally destructed.
-    if (_activity->IsActive() == true) {
-
-        _activity->Update(info);
-
-        if (_activity->IsActive() == false) {
-            uint32_t result = _activity->ExitCode();
-
-            if (result != Core::ERROR_NONE) {
-                if (_deactivationInProgress == false) {
-                    _deactivationInProgress = true;
-                    SYSLOG(Logging::Fatal, (_T("FORCED Shutdown: %s by error: %d."), _service->Callsign().c_str(), result));
-                    Core::WorkerPool::Instance().Submit(PluginHost::IShell::Job::Create(_service, PluginHost::IShell::DEACTIVATED, PluginHost::IShell::FAILURE));
-                }
-            }
-            else if (_activity->Continuous() == false) {
-                if (_deactivationInProgress == false) {
-                    _deactivationInProgress = true;
-                    TRACE(Trace::Information, (_T("Launcher [%s] has run succesfully, deactivation requested."), _service->Callsign().c_str()));
-                    Core::WorkerPool::Instance().Submit(PluginHost::IShell::Job::Create(_service, PluginHost::IShell::DEACTIVATED, PluginHost::IShell::AUTOMATIC));
-                }
+    // This is called from the workerpool job delivering the process events, so the deactivation (wich in turn kills this 
+    // object) must be done on a seperate job. Also make sure this call-stack can be unwound before we are totally destructed.
+    // The Activities are released while the launch of one of them might still report, so walk them under the lock, once
+    // they are handed over to the Cleanup there is nothing left to walk.
+    _adminLock.Lock();
+
+    ASSERT((_activities.empty() == true) || (_service != nullptr));
+
+    for (Core::ProxyType<Job>& activity : _activities) {
+        if ((activity->IsActive() == true) && (activity->Update(info) == true)) {
+            Evaluate(*activity);
+            break;
+        }
+    }
+
+    _adminLock.Unlock();
+}
+
+void Launcher::Resync()
+{
+    // Called from the resource monitor if a control group changed, that can race the Cleanup, see Update.
+    _adminLock.Lock();
+
+    ASSERT((_activities.empty() == true) || (_service != nullptr));
+
+    for (Core::ProxyType<Job>& activity : _activities) {
+        if (activity->IsActive() == true) {
+
+            activity->Resync();
+
+            Evaluate(*activity);
+        }
+    }
+
+    _adminLock.Unlock();
+}
+
+void Launcher::Reap()
+{
+    // Only for the Activities that could not collect all exits yet, see Update.
+    _adminLock.Lock();
+
+    for (Core::ProxyType<Job>& activity : _activities) {
+        if (activity->Reaping() == true) {
+            Evaluate(*activity);
+        }
+    }
+
+    _adminLock.Unlock();
+}
+
+void Launcher::Evaluate(Job& job)
+{
+    // With concurrent runs, one can complete while others are still active.
+    uint32_t result = job.ExitCode();
+
+    if ((result != Core::ERROR_NONE) || (job.IsActive() == false)) {
+
+        _adminLock.Lock();
+
+        if (result != Core::ERROR_NONE) {
+            if (_deactivationInProgress == false) {
+                string tail;
+
+                // What it said last, likely tells why.
+                job.Tail(tail, FailureTail);
+
+                _deactivationInProgress = true;
+                SYSLOG(Logging::Fatal, (_T("FORCED Shutdown: %s by error: %d.%s%s"), _service->Callsign().c_str(), result, (tail.empty() == true ? _T("") : _T(" Last output:\n")), tail.c_str()));
+                Core::WorkerPool::Instance().Submit(PluginHost::IShell::Job::Create(_service, PluginHost::IShell::DEACTIVATED, PluginHost::IShell::FAILURE));
             }
-            else {
-                TRACE(Trace::Information, (_T("Launcher [%s] has run succesfully, scheduled for the next run."), _service->Callsign().c_str()));
+        }
+        else if (std::all_of(_activities.begin(), _activities.end(), [](const Core::ProxyType<Job>& activity) { return (activity->Finished()); }) == true) {
+            if (_deactivationInProgress == false) {
+                _deactivationInProgress = true;
+                TRACE(Trace::Information, (_T("Launcher [%s] has run succesfully, deactivation requested."), _service->Callsign().c_str()));
+                Core::WorkerPool::Instance().Submit(PluginHost::IShell::Job::Create(_service, PluginHost::IShell::DEACTIVATED, PluginHost::IShell::AUTOMATIC));
             }
         }
+        else if (job.Continuous() == true) {
+            TRACE(Trace::Information, (_T("Launcher [%s] has run %s succesfully, scheduled for the next run."), _service->Callsign().c_str(), job.Command().c_str()));
+        }
+
+        _adminLock.Unlock();
     }
 }
 
-bool Launcher::ScheduleParameters(const Config& config, string& message, Core::Time& scheduleTime, Time& interval) {
+bool Launcher::ScheduleParameters(const Config::Schedule& schedule, string& message, Plan& plan) {
+
+    Core::Time& scheduleTime(plan.Start);
+    Time& interval(plan.Interval);
 
     // initialize with defaults..
     scheduleTime = Core::Time::Now();
     interval = Time();
+    plan.Calendar = Cron();
 
     // Only if a schedule section is set, we need to do something..
-    if (config.ScheduleTime.IsSet() == true) {
+    if ((schedule.IsSet() == true) && (schedule.Mode.Value() == CRON)) {
+        // Compiled once, the runs are taken from it from here on.
+        if (plan.Calendar.Parse(schedule.Time.Value()) == false) {
+            message = _T("Incorrect cron expression for Scheduled time.");
+        }
+        else {
+            const uint64_t next = plan.Calendar.Next(scheduleTime.Ticks());
 
-        mode timeMode = config.ScheduleTime.Mode.Value();
-        Time time(config.ScheduleTime.Time.Value());
+            if (next == 0) {
+                message = _T("The cron expression for Scheduled time never matches.");
+            }
+            else {
+                scheduleTime = Core::Time(next);
+            }
+        }
+    }
+    else if (schedule.IsSet() == true) {
 
-        interval = Time(config.ScheduleTime.Interval.Value());
+        mode timeMode = schedule.Mode.Value();
+        Time time(schedule.Time.Value());
+
+        interval = Time(schedule.Interval.Value());
 
         if (time.IsValid() != true) {
             message = _T("Incorrect time format for Scheduled time.");
         }
-        else if ( (config.ScheduleTime.Interval.IsSet() == true) && (interval.IsValid() != true) ) {
+        else if ( (schedule.Interval.IsSet() == true) && (interval.IsValid() != true) ) {
             message = _T("Incorrect time format for Interval time.");
         }
         else if ( (timeMode == ABSOLUTE_WITH_INTERVAL) && ((interval.IsValid() == false) || (interval.TimeInSeconds() == 0)) ) {
@@ -154,42 +452,75 @@ bool Launcher::ScheduleParameters(const Config& config, string& message, Core::T
         }
         else {
             // All signals green, we have valid input, calculate the ScheduleTime/Interval time
+            const uint64_t now = scheduleTime.Ticks();
+            const int8_t hours = (time.HasHours() ? time.Hours() : Timing::Any);
+            const int8_t minutes = (time.HasMinutes() ? time.Minutes() : Timing::Any);
+            const uint8_t seconds = (time.HasSeconds() ? time.Seconds() : 0);
+
             if (timeMode == RELATIVE) { //Schedule Job at relative timing
-                scheduleTime.Add(time.TimeInSeconds() * Time::MilliSecondsPerSecond);
+                scheduleTime = Core::Time(Timing::Relative(now, time.TimeInSeconds()));
+            }
+            else if (timeMode == ABSOLUTE_WITH_INTERVAL) {
+                // The first start on the grid of the interval through the given time, that is not before now.
+                scheduleTime = Core::Time(Timing::Aligned(now, hours, minutes, seconds, interval.TimeInSeconds()));
             }
             else {
-                Core::Time now (scheduleTime);
                 // Go to a first viable start time (compared to the current time, in seconds)
-                scheduleTime = Core::Time(now.Year(), now.Month(), now.Day(),
-                                             (time.HasHours()   ? time.Hours()   : now.Hours()),
-                                             (time.HasMinutes() ? time.Minutes() : now.Minutes()),
-                                              time.Seconds(), 0, false);
+                scheduleTime = Core::Time(Timing::Absolute(now, hours, minutes, seconds));
+            }
+        }
+    }
+    return (message.empty());
+}
+
+bool Launcher::ResourceParameters(const Config::Resources& resources, string& message, Plan& plan) {
 
-                if (timeMode == ABSOLUTE_WITH_INTERVAL) {
-                    uint32_t intervalJump = interval.TimeInSeconds() * Time::MilliSecondsPerSecond;
+    Scheduling& scheduling(plan.Tuning);
+    const string& list(resources.Affinity.Value());
+    size_t position = 0;
 
-                    if (scheduleTime >= now) {
-                        Core::Time workTime (scheduleTime);
+    ::memset(&scheduling, 0, sizeof(scheduling));
+    CPU_ZERO(&scheduling.Affinity);
 
-                        while (workTime.Sub(intervalJump) > now) { scheduleTime.Sub(intervalJump); }
-                    }
-                    else {
-                        // Now increment with the interval till we reach a valid point
-                        while (scheduleTime < now) { scheduleTime.Add(intervalJump); }
-                    }
-                }
-                else if (scheduleTime < now) {
-                    uint32_t jump = (time.HasHours()   ? Time::HoursPerDay * Time::MinutesPerHour * Time::SecondsPerMinute :
-                                    (time.HasMinutes() ? Time::MinutesPerHour * Time::SecondsPerMinute : Time::SecondsPerMinute));
+    // A list of CPUs and ranges of them, e.g. "0-1,3".
+    while ((message.empty() == true) && (position < list.length())) {
+        char* end;
+        const unsigned long first = ::strtoul(&(list[position]), &end, 10);
+        unsigned long last = first;
 
-                    scheduleTime.Add(jump * Time::MilliSecondsPerSecond);
-                }
+        if (*end == '-') {
+            last = ::strtoul(end + 1, &end, 10);
+        }
+
+        if ((end == &(list[position])) || ((*end != ',') && (*end != '\0')) || (last < first) || (last >= CPU_SETSIZE)) {
+            message = _T("Incorrect CPU list for the affinity.");
+        }
+        else {
+            for (unsigned long cpu = first; cpu <= last; cpu++) {
+                CPU_SET(cpu, &scheduling.Affinity);
             }
+            position = (end - list.c_str()) + 1;
         }
     }
+
+    if (message.empty() == true) {
+        if ((resources.Nice.Value() < -20) || (resources.Nice.Value() > 19)) {
+            message = _T("Nice value out of range, it should be between -20 and 19.");
+        }
+        else if (resources.IoLevel.Value() > 7) {
+            message = _T("I/O level out of range, it should be between 0 and 7.");
+        }
+        else {
+            scheduling.Policy = resources.Policy.Value();
+            scheduling.Nice = resources.Nice.Value();
+            // The level is meaningless for the idle class.
+            scheduling.IoPriority = (resources.IoClass.Value() == IO_NONE ? 0 : (resources.IoClass.Value() << 13) | (resources.IoClass.Value() == IO_IDLE ? 0 : resources.IoLevel.Value()));
+        }
+    }
+
     return (message.empty());
 }
- 
+
 } //namespace Plugin
 
 } // namespace Thunder
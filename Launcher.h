@@ -1,14 +1,41 @@
 #pragma once
 
 #include "Module.h"
+#include "Spawn.h"
+#include "Timing.h"
+#include "Zygote.h"
 #include <interfaces/IMemory.h>
 #include <linux/cn_proc.h>
+#include <linux/filter.h>
+#include <linux/sock_diag.h>
+#include <arpa/inet.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/sysinfo.h>
+#include <sys/timerfd.h>
+#include <sys/wait.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace Thunder {
 namespace Plugin {
 
-class Launcher : public PluginHost::IPlugin {
+class Launcher : public PluginHost::IPlugin, public PluginHost::JSONRPC {
 private:
     Launcher(const Launcher&) = delete;
     Launcher& operator=(const Launcher&) = delete;
@@ -17,7 +44,71 @@ public:
     enum mode {
         RELATIVE,
         ABSOLUTE,
-        ABSOLUTE_WITH_INTERVAL
+        ABSOLUTE_WITH_INTERVAL,
+        CRON
+    };
+
+    enum backend {
+        NETLINK,
+        PIDFD
+    };
+
+    enum accounting {
+        STATM,
+        PROPORTIONAL
+    };
+
+    enum order {
+        FIFO,
+        PRIORITY
+    };
+
+    enum catchup {
+        SKIP,
+        ONCE,
+        ALL
+    };
+
+    enum overlap {
+        DISCARD,
+        QUEUE,
+        CONCURRENT,
+        RESTART
+    };
+
+    enum termination {
+        HANGUP = SIGHUP,
+        INTERRUPT = SIGINT,
+        QUIT = SIGQUIT,
+        TERMINATE = SIGTERM,
+        KILL = SIGKILL,
+        USER1 = SIGUSR1,
+        USER2 = SIGUSR2
+    };
+
+    enum target {
+        ROOT,
+        GROUP,
+        TREE
+    };
+
+    enum supervision {
+        NEVER,
+        ON_FAILURE,
+        ALWAYS
+    };
+
+    enum policy {
+        OTHER = SCHED_OTHER,
+        BATCH = SCHED_BATCH,
+        IDLE = SCHED_IDLE
+    };
+
+    enum ioclass {
+        IO_NONE = 0,
+        IO_REALTIME = 1,
+        IO_BESTEFFORT = 2,
+        IO_IDLE = 3
     };
 
     class ProcessObserver {
@@ -26,7 +117,9 @@ public:
         ProcessObserver& operator= (const ProcessObserver&) = delete;
 
     public:
-        class Info : public Core::ConnectorType<CN_IDX_PROC,CN_VAL_PROC> {
+        // A view on a single event, as received from the kernel. It does not copy the event, so it 
+        // is only valid as long as the buffer holding the event is.
+        class Info {
         public:
             enum event {
                 EVENT_NONE = proc_event::PROC_EVENT_NONE,
@@ -39,38 +132,33 @@ public:
 
         public:
             Info() = delete;
-            Info(const Info&) = delete;
-            Info& operator= (const Info&) = delete;
+            Info(const Info&) = default;
+            Info& operator= (const Info&) = default;
 
-            Info(const uint8_t buffer[], const uint16_t length) 
-                : _status(PROC_CN_MCAST_IGNORE) {
-                if (Ingest(buffer, length) == false) {
-                    TRACE(Trace::Fatal, (_T("Could not observe the process!!!")));
-                    _info.what = proc_event::PROC_EVENT_NONE;
-                }
-            }
-            Info(const bool enabled) 
-                : _status(enabled ? PROC_CN_MCAST_LISTEN : PROC_CN_MCAST_IGNORE) {
-                _info.what = proc_event::PROC_EVENT_NONE;
+            Info(const proc_event& info)
+                : _info(&info) {
             }
-            ~Info() override = default;
+            ~Info() = default;
 
         public:
+            inline const proc_event& Data() const {
+                return(*_info);
+            }
             inline event Event() const {
-                return(static_cast<event>(_info.what));
+                return(static_cast<event>(_info->what));
             }
             inline uint32_t Id () const {
                 switch (Event()) {
                 case EVENT_FORK:
-                    return (_info.event_data.fork.parent_pid);
+                    return (_info->event_data.fork.parent_pid);
                 case EVENT_EXEC:
-                    return (_info.event_data.exec.process_pid);
+                    return (_info->event_data.exec.process_pid);
                 case EVENT_UID:
-                    return (_info.event_data.id.process_pid);
+                    return (_info->event_data.id.process_pid);
                 case EVENT_GID:
-                    return (_info.event_data.id.process_pid);
+                    return (_info->event_data.id.process_pid);
                 case EVENT_EXIT:
-                    return (_info.event_data.exit.process_pid);
+                    return (_info->event_data.exit.process_pid);
                 default:
                     break;
                 }
@@ -79,56 +167,85 @@ public:
             inline uint32_t Group () const {
                 switch (Event()) {
                 case EVENT_FORK:
-                    return (_info.event_data.fork.parent_tgid);
+                    return (_info->event_data.fork.parent_tgid);
                 case EVENT_EXEC:
-                    return (_info.event_data.exec.process_tgid);
+                    return (_info->event_data.exec.process_tgid);
                 case EVENT_UID:
-                    return (_info.event_data.id.process_tgid);
+                    return (_info->event_data.id.process_tgid);
                 case EVENT_GID:
-                    return (_info.event_data.id.process_tgid);
+                    return (_info->event_data.id.process_tgid);
                 case EVENT_EXIT:
-                    return (_info.event_data.exit.process_tgid);
+                    return (_info->event_data.exit.process_tgid);
                 default:
                     break;
                 }
                 return(0);
             }
             inline uint32_t ChildId () const {
-                return(Event() == EVENT_FORK ? _info.event_data.fork.child_pid : 0);
+                return(Event() == EVENT_FORK ? _info->event_data.fork.child_pid : 0);
             }
             inline uint32_t ChildGroup () const {
-                return(Event() == EVENT_FORK ? _info.event_data.fork.child_tgid : 0);
+                return(Event() == EVENT_FORK ? _info->event_data.fork.child_tgid : 0);
             }
             inline uint32_t ExitCode () const {
-                return(Event() == EVENT_EXIT ? _info.event_data.exit.exit_code : 0);
+                return(Event() == EVENT_EXIT ? _info->event_data.exit.exit_code : 0);
             }
             inline uint32_t UserId () const {
-                return((Event() == EVENT_UID) || (Event() == EVENT_GID) ? _info.event_data.id.r.ruid : 0);
+                return((Event() == EVENT_UID) || (Event() == EVENT_GID) ? _info->event_data.id.r.ruid : 0);
             }
             inline uint32_t GroupId () const {
-                return((Event() == EVENT_UID) || (Event() == EVENT_GID) ? _info.event_data.id.e.egid : 0);
+                return((Event() == EVENT_UID) || (Event() == EVENT_GID) ? _info->event_data.id.e.egid : 0);
+            }
+
+        private:
+            const proc_event* _info;
+        };
+
+        typedef std::vector<Info> Batch;
+
+        class Subscription : public Core::ConnectorType<CN_IDX_PROC,CN_VAL_PROC> {
+        public:
+            Subscription() = delete;
+            Subscription(const Subscription&) = delete;
+            Subscription& operator= (const Subscription&) = delete;
+
+            Subscription(const bool enabled) 
+                : _status(enabled ? PROC_CN_MCAST_LISTEN : PROC_CN_MCAST_IGNORE) {
             }
+            ~Subscription() override = default;
+
+        public:
             uint16_t Message(uint8_t stream[], const uint16_t /* length */) const override { 
     
                 memcpy(stream, &_status, sizeof(_status)); 
     
                 return (sizeof(_status)); 
             } 
-            uint16_t Message(const uint8_t stream[], const uint16_t length) override { 
-                uint16_t toCopy = (length >= sizeof(proc_event) ? sizeof(proc_event) : length);
-                ::memcpy(&_info, stream, toCopy);
-                if (toCopy < sizeof(proc_event)) {
-                    ::memset(&(reinterpret_cast<uint8_t*>(&_info)[toCopy]), 0, sizeof(proc_event) - toCopy);
-                }
-                return (length >= sizeof(_info.what) ? length : 0);
+            uint16_t Message(const uint8_t /* stream */[], const uint16_t length) override { 
+                return (length);
             }
 
         private:
             proc_cn_mcast_op _status;
-            proc_event _info;
         };
 
-        class Channel : public Core::SocketNetlink {
+        // Where the process events come from. All events of a source must be reported from a single 
+        // thread, the same thread on which the source is asked to (un)watch processes.
+        struct ISource {
+            virtual ~ISource() {}
+
+            virtual bool Start() = 0;
+            virtual void Stop() = 0;
+
+            // The process is added to/removed from the process table.
+            virtual void Watch(const uint32_t pid) = 0;
+            virtual void Unwatch(const uint32_t pid) = 0;
+        };
+
+        class Channel : public Core::SocketNetlink, public ISource {
+        private:
+            static constexpr uint16_t BatchSize = 32;
+
         public:
             Channel() = delete;
             Channel(const Channel&) = delete;
@@ -136,599 +253,4707 @@ public:
 
             Channel(ProcessObserver& parent) 
                 : Core::SocketNetlink(Core::NodeId(NETLINK_CONNECTOR, 0, CN_IDX_PROC))
-                , _parent(parent) {
+                , _parent(parent)
+                , _batch()
+                , _filtered(false)
+                , _drops(0)
+                , _cpus(static_cast<uint32_t>(std::max(::get_nprocs_conf(), 1)))
+                , _sequence() {
+                _batch.reserve(BatchSize);
             }
             ~Channel() override = default;
 
+        public:
+            bool Start() override {
+                bool succeeded = true;
+                ASSERT (IsOpen() == false);
+
+                if (Open(Core::infinite) == Core::ERROR_NONE) {
+                    Subscription message(true);
+
+                    if (Filter() == false) {
+                        TRACE(Trace::Information, (_T("Could not attach the process event filter, all events will be processed.")));
+                    }
+
+                    if (Send(message, Core::infinite) != Core::ERROR_NONE) {
+                        Close(Core::infinite);
+                        succeeded = false;
+                    }
+                }
+                return (succeeded);
+            }
+            void Stop() override {
+                if (IsOpen() == true) {
+
+                    Subscription message(false);
+                    Send (message, Core::infinite);
+                }
+                Close(Core::infinite);
+            }
+            // The kernel reports all processes in the system, nothing to do here.
+            void Watch(const uint32_t /* pid */) override {
+            }
+            void Unwatch(const uint32_t /* pid */) override {
+            }
+
         private:
+            // Install a kernel side filter on the socket. The proc connector is a system wide 
+            // broadcast, so without it every EXEC/UID/GID/... event and every thread creation/exit
+            // on the box is copied into our process, only to be ignored by the Jobs. We only let 
+            // through the subscription acknowledgement and FORK/EXIT events of whole processes, 
+            // so the pid/tgid the Jobs track are all process (thread group) identifiers.
+            bool Filter() {
+                static constexpr uint32_t Event = NLMSG_HDRLEN + sizeof(cn_msg) + offsetof(proc_event, what);
+                static constexpr uint32_t ForkPid = NLMSG_HDRLEN + sizeof(cn_msg) + offsetof(proc_event, event_data.fork.child_pid);
+                static constexpr uint32_t ForkTgid = NLMSG_HDRLEN + sizeof(cn_msg) + offsetof(proc_event, event_data.fork.child_tgid);
+                static constexpr uint32_t ExitPid = NLMSG_HDRLEN + sizeof(cn_msg) + offsetof(proc_event, event_data.exit.process_pid);
+                static constexpr uint32_t ExitTgid = NLMSG_HDRLEN + sizeof(cn_msg) + offsetof(proc_event, event_data.exit.process_tgid);
+
+                // Loads from a netlink socket filter are done in network byte order, hence the htonl's.
+                struct sock_filter program[] = {
+                    /*  0 */ BPF_STMT(BPF_LD  | BPF_W   | BPF_ABS, Event),
+                    /*  1 */ BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, htonl(proc_event::PROC_EVENT_NONE), 13, 0),
+                    /*  2 */ BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, htonl(proc_event::PROC_EVENT_FORK), 0, 5),
+                    /*  3 */ BPF_STMT(BPF_LD  | BPF_W   | BPF_ABS, ForkTgid),
+                    /*  4 */ BPF_STMT(BPF_ST, 0),
+                    /*  5 */ BPF_STMT(BPF_LDX | BPF_W   | BPF_MEM, 0),
+                    /*  6 */ BPF_STMT(BPF_LD  | BPF_W   | BPF_ABS, ForkPid),
+                    /*  7 */ BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_X, 0, 7, 6),
+                    /*  8 */ BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, htonl(proc_event::PROC_EVENT_EXIT), 0, 5),
+                    /*  9 */ BPF_STMT(BPF_LD  | BPF_W   | BPF_ABS, ExitTgid),
+                    /* 10 */ BPF_STMT(BPF_ST, 0),
+                    /* 11 */ BPF_STMT(BPF_LDX | BPF_W   | BPF_MEM, 0),
+                    /* 12 */ BPF_STMT(BPF_LD  | BPF_W   | BPF_ABS, ExitPid),
+                    /* 13 */ BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_X, 0, 1, 0),
+                    /* 14 */ BPF_STMT(BPF_RET | BPF_K, 0),
+                    /* 15 */ BPF_STMT(BPF_RET | BPF_K, 0xFFFFFFFF)
+                };
+                struct sock_fprog filter = { static_cast<unsigned short>(sizeof(program) / sizeof(program[0])), program };
+
+                _filtered = (::setsockopt(Descriptor(), SOL_SOCKET, SO_ATTACH_FILTER, &filter, sizeof(filter)) == 0);
+                _drops = 0;
+                _sequence.clear();
+
+                return (_filtered);
+            }
+
+        private:
+            // The kernel counts the events it could not queue on an overrun socket.
+            uint32_t Drops() const {
+                uint32_t drops = 0;
+#ifdef SO_MEMINFO
+                uint32_t info[SK_MEMINFO_VARS];
+                socklen_t length = sizeof(info);
+
+                if ( (::getsockopt(Descriptor(), SOL_SOCKET, SO_MEMINFO, info, &length) == 0) && (length > (SK_MEMINFO_DROPS * sizeof(uint32_t))) ) {
+                    drops = info[SK_MEMINFO_DROPS];
+                }
+#endif
+                return (drops);
+            }
+            // The kernel numbers the events per CPU. Only if all events are passed (no filter attached),
+            // a gap in that numbering means events got lost. The subscription acknowledgement is not
+            // numbered, it carries no CPU (~0), and neither is a CPU the system can never have.
+            uint32_t Gap(const cn_msg& message, const proc_event& event) {
+                static constexpr uint32_t Unknown = ~0;
+                uint32_t result = 0;
+
+                if ( (_filtered == false) && (event.what != proc_event::PROC_EVENT_NONE) && (event.cpu < _cpus) ) {
+                    if (event.cpu >= _sequence.size()) {
+                        _sequence.resize(event.cpu + 1, Unknown);
+                    }
+                    uint32_t& expected(_sequence[event.cpu]);
+
+                    if ( (expected != Unknown) && (static_cast<int32_t>(message.seq - expected) > 0) ) {
+                        result = message.seq - expected;
+                    }
+                    expected = message.seq + 1;
+                }
+                return (result);
+            }
+            // Under load the kernel packs multiple events in a single frame. Report all of them, as
+            // views on the receive buffer, in one go.
             virtual uint16_t Deserialize (const uint8_t dataFrame[], const uint16_t receivedSize) {
-                _parent.Received (Info(dataFrame, receivedSize));
+                const nlmsghdr* header = reinterpret_cast<const nlmsghdr*>(dataFrame);
+                int length = receivedSize;
+                uint32_t drops = Drops();
+                uint32_t lost = drops - _drops;
+
+                _drops = drops;
+                _batch.clear();
+
+                while (NLMSG_OK(header, length)) {
+                    if (header->nlmsg_type == NLMSG_DONE) {
+                        const cn_msg* message = reinterpret_cast<const cn_msg*>(NLMSG_DATA(header));
+
+                        if ( (NLMSG_PAYLOAD(header, 0) >= sizeof(cn_msg)) &&
+                             (message->id.idx == CN_IDX_PROC) && (message->id.val == CN_VAL_PROC) &&
+                             (message->len >= sizeof(proc_event)) && (NLMSG_PAYLOAD(header, 0) >= (sizeof(cn_msg) + message->len)) ) {
+                            const proc_event& event(*reinterpret_cast<const proc_event*>(message->data));
+
+                            lost += Gap(*message, event);
+                            _batch.emplace_back(event);
+                        }
+                        else {
+                            TRACE(Trace::Error, (_T("Could not observe the process, unexpected message!!!")));
+                        }
+                    }
+                    header = NLMSG_NEXT(header, length);
+                }
+
+                if (_batch.empty() == false) {
+                    _parent.Received(_batch);
+                }
+                if (lost != 0) {
+                    _parent.Overrun(lost);
+                }
+
                 return (receivedSize);
             }
 
         private:
             ProcessObserver& _parent;
+            Batch _batch;
+            bool _filtered;
+            uint32_t _drops;
+            const uint32_t _cpus;
+            std::vector<uint32_t> _sequence;
         };
 
-    public:
-        struct IProcessState {
-            virtual ~IProcessState() {}
+        // Tracks processes through a pidfd each, so no privileges are required and only the processes
+        // of interest cost anything. The kernel does not report forks on a pidfd, so the children of the 
+        // tracked processes are polled from /proc. Children that are forked and reparented (their parent
+        // exited) in between two polls are missed. The pidfds and the poll timer are multiplexed on one
+        // epoll descriptor, so just like the netlink channel, all events are reported from one thread.
+        class PidChannel : public Core::IResource, public ISource {
+        private:
+            static constexpr uint32_t PollPeriod = 250; // ms
+            static constexpr uint16_t MaxEvents = 16;
+            static constexpr uint32_t Timer = 0;
 
-            virtual void Update(const Info&) = 0;
-        };
+            typedef std::unordered_map<uint32_t, int> Descriptors;
 
-    public:
-        ProcessObserver()
-            : _adminLock()
-            , _channel(*this)
-            , _callbacks() {
-        }
-        ~ProcessObserver() {
-            ASSERT(_callbacks.empty());
-        }
+        public:
+            PidChannel() = delete;
+            PidChannel(const PidChannel&) = delete;
+            PidChannel& operator= (const PidChannel&) = delete;
 
-    public:
-        void Register(IProcessState* observer) {
-            _adminLock.Lock();
-            ASSERT (std::find(_callbacks.begin(), _callbacks.end(), observer) == _callbacks.end());
-            if (_callbacks.empty()) {
-                const bool opened = Open();
-                DEBUG_VARIABLE(opened);
-                ASSERT(opened);
+            PidChannel(ProcessObserver& parent)
+                : _parent(parent)
+                , _epoll(-1)
+                , _timer(-1)
+                , _children(false)
+                , _descriptors()
+                , _gone()
+                , _events()
+                , _batch() {
             }
-            _callbacks.push_back(observer);
-            _adminLock.Unlock();
-        }
-        void Unregister(IProcessState* observer) {
-            _adminLock.Lock();
-            auto found = std::find(_callbacks.begin(), _callbacks.end(), observer);
-            ASSERT(found != _callbacks.end());
-            _callbacks.erase(found); 
-            if (_callbacks.empty()) {
-                Close();
+            ~PidChannel() override {
+                Stop();
             }
-            _adminLock.Unlock();
-        }
 
-    private:
-        bool Open() {
-            bool succeeded = true;
-            ASSERT (_channel.IsOpen() == false);
+        public:
+            bool Start() override {
+                ASSERT (_epoll == -1);
+
+                _epoll = ::epoll_create1(EPOLL_CLOEXEC);
+                _timer = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+
+                if ((_epoll != -1) && (_timer != -1)) {
+                    struct epoll_event event;
+                    struct itimerspec period;
+
+                    event.events = EPOLLIN;
+                    event.data.u64 = Timer;
+                    period.it_interval.tv_sec = PollPeriod / 1000;
+                    period.it_interval.tv_nsec = (PollPeriod % 1000) * 1000000;
+                    period.it_value = period.it_interval;
 
-            if (_channel.Open(Core::infinite) == Core::ERROR_NONE) {
-                Info message(true);
+                    if ( (::epoll_ctl(_epoll, EPOLL_CTL_ADD, _timer, &event) == 0) && (::timerfd_settime(_timer, 0, &period, nullptr) == 0) ) {
+                        std::vector<uint32_t> children;
 
-                if (_channel.Send(message, Core::infinite) != Core::ERROR_NONE) {
-                    _channel.Close(Core::infinite);
-                    succeeded = false;
+                        _children = ProcessTree::Children(::getpid(), children);
+
+                        if (_children == false) {
+                            TRACE(Trace::Information, (_T("No children lists available in /proc, falling back to scanning all processes.")));
+                        }
+
+                        Core::ResourceMonitor::Instance().Register(*this);
+                        return (true);
+                    }
                 }
+
+                Close();
+                return (false);
             }
-            return (succeeded);
-        }
-        bool Close() {
-            if (_channel.IsOpen() == true) {
+            void Stop() override {
+                if (_epoll != -1) {
+                    Core::ResourceMonitor::Instance().Unregister(*this);
 
-                Info message(false);
-                _channel.Send (message, Core::infinite);
+                    for (const std::pair<const uint32_t, int>& entry : _descriptors) {
+                        if (entry.second != -1) {
+                            ::close(entry.second);
+                        }
+                    }
+                    _descriptors.clear();
+                    _gone.clear();
+                }
+                Close();
             }
-            _channel.Close(Core::infinite);
+            void Watch(const uint32_t pid) override {
+                if (_descriptors.find(pid) == _descriptors.end()) {
+                    int fd = static_cast<int>(::syscall(__NR_pidfd_open, pid, 0));
 
-            return (Core::ERROR_NONE);
-        }
+                    if (fd != -1) {
+                        struct epoll_event event;
+                        event.events = EPOLLIN;
+                        event.data.u64 = pid;
 
-    private:
-        void Received (const Info& info) {
-            if (!_callbacks.empty()) {
-                _adminLock.Lock();
+                        ::epoll_ctl(_epoll, EPOLL_CTL_ADD, fd, &event);
+                        _descriptors[pid] = fd;
+                    }
+                    else if (errno == ESRCH) {
+                        // Already gone before we could watch it, report it on the next round.
+                        _gone.push_back(pid);
+                    }
+                    else {
+                        // No pidfd support, its existence will be polled.
+                        _descriptors[pid] = -1;
+                    }
+                }
+            }
+            void Unwatch(const uint32_t pid) override {
+                Descriptors::iterator index(_descriptors.find(pid));
 
-                for (auto* callback : _callbacks) {
-                    callback->Update(info);
+                if (index != _descriptors.end()) {
+                    if (index->second != -1) {
+                        ::epoll_ctl(_epoll, EPOLL_CTL_DEL, index->second, nullptr);
+                        ::close(index->second);
+                    }
+                    _descriptors.erase(index);
                 }
+            }
 
-                _adminLock.Unlock();
+        private:
+            handle Descriptor() const override {
+                return (_epoll);
             }
-        }
+            uint16_t Events() override {
+                return (POLLIN);
+            }
+            void Handle(const uint16_t /* events */) override {
+                struct epoll_event ready[MaxEvents];
+                bool poll = false;
+                int count;
 
-    private:
-        Core::CriticalSection _adminLock;
-        Channel _channel;
-        std::vector<IProcessState*> _callbacks;
-    };
+                _events.clear();
 
-    class Notification : public ProcessObserver::IProcessState {
-    private:
-        Notification() = delete;
-        Notification(const Notification&) = delete;
+                while ((count = ::epoll_wait(_epoll, ready, MaxEvents, 0)) > 0) {
+                    for (int index = 0; index < count; index++) {
+                        if (ready[index].data.u64 == Timer) {
+                            uint64_t expirations;
+                            if (::read(_timer, &expirations, sizeof(expirations)) > 0) {
+                                poll = true;
+                            }
+                        }
+                        else {
+                            const uint32_t pid = static_cast<uint32_t>(ready[index].data.u64);
+                            Descriptors::const_iterator entry(_descriptors.find(pid));
 
-    public:
-        explicit Notification(Launcher* parent)
-            : _parent(*parent)
-        {
-            ASSERT(parent != nullptr);
-        }
-        ~Notification() override = default;
+                            if (entry != _descriptors.end()) {
+                                // Level triggered, so stop listening till the observer drops it.
+                                ::epoll_ctl(_epoll, EPOLL_CTL_DEL, entry->second, nullptr);
+                                Exit(pid);
+                            }
+                        }
+                    }
+                    if (count < MaxEvents) {
+                        break;
+                    }
+                }
 
-    public:
-        void Update(const ProcessObserver::Info& info) override {
-            _parent.Update(info);
-        }
+                if (poll == true) {
+                    Poll();
+                }
 
-    private:
-        Launcher& _parent;
-    };
+                // Always report, even without events, so the pending requests of the observer are applied.
+                Report();
 
-    class MemoryObserverImpl : public Exchange::IMemory {
-    private:
-        MemoryObserverImpl();
-        MemoryObserverImpl(const MemoryObserverImpl&);
-        MemoryObserverImpl& operator=(const MemoryObserverImpl&);
+                while (_gone.empty() == false) {
+                    std::vector<uint32_t> gone;
+                    gone.swap(_gone);
 
-    public:
-        MemoryObserverImpl(const uint32_t id)
-            : _main(id == 0 ? Core::ProcessInfo().Id() : id)
-            , _observable(false)
-        {
-        }
-        ~MemoryObserverImpl()
-        {
-        }
+                    _events.clear();
+                    for (const uint32_t pid : gone) {
+                        Exit(pid);
+                    }
+                    Report();
+                }
+            }
+            void Poll() {
+                ProcessTree::Parents parents;
+                std::vector<uint32_t> pending;
+                std::unordered_set<uint32_t> found;
 
-    public:
-        virtual void Observe(const uint32_t pid)
-        {
-            if (pid == 0) {
-                _observable = false;
-             }
-             else {
-                _main = Core::ProcessInfo(pid);
-                _observable = true;
-             }
-        }
-        virtual uint64_t Resident() const
-        {
-            return (_observable == false ? 0 : _main.Resident());
-        }
-        virtual uint64_t Allocated() const
-        {
-            return (_observable == false ? 0 : _main.Allocated());
-        }
-        virtual uint64_t Shared() const
-        {
-            return (_observable == false ? 0 : _main.Shared());
-        }
-        virtual uint8_t Processes() const
-        {
-            return (IsOperational() ? 1 : 0);
-        }
-        virtual bool IsOperational() const
-        {
-            return (_observable == false) || (_main.IsActive());
-        }
+                if (_children == false) {
+                    ProcessTree::Snapshot(parents);
+                }
 
-        BEGIN_INTERFACE_MAP(MemoryObserverImpl)
-        INTERFACE_ENTRY(Exchange::IMemory)
-        END_INTERFACE_MAP
+                for (const std::pair<const uint32_t, int>& entry : _descriptors) {
+                    uint32_t parent;
 
-    private:
-        Core::ProcessInfo _main;
-        bool _observable;
-    };
+                    if ((entry.second == -1) && (ProcessTree::Parent(entry.first, parent) == false)) {
+                        Exit(entry.first);
+                    }
+                    else {
+                        pending.push_back(entry.first);
+                    }
+                }
 
-public:
-    class Config : public Core::JSON::Container {
-    private:
-        Config(const Config&) = delete;
-        Config& operator=(const Config&) = delete;
+                if (_children == false) {
+                    for (const std::pair<const uint32_t, uint32_t>& entry : parents) {
+                        if ( (_descriptors.find(entry.first) == _descriptors.end()) && (_descriptors.find(entry.second) != _descriptors.end()) ) {
+                            Fork(entry.second, entry.first);
+                        }
+                    }
+                }
+                else {
+                    // New children are searched for children as well, so a whole new branch is found in one go.
+                    while (pending.empty() == false) {
+                        std::vector<uint32_t> children;
+                        const uint32_t pid = pending.back();
+                        pending.pop_back();
 
-    public:
-        class Parameter : public Core::JSON::Container {
-        private:
-            Parameter& operator=(const Parameter&) = delete;
+                        ProcessTree::Children(pid, children);
 
-        public:
-            Parameter()
-                : Core::JSON::Container()
-                , Option()
-                , Value() {
-                Add(_T("option"), &Option);
-                Add(_T("value"), &Value);
+                        for (const uint32_t child : children) {
+                            if ( (_descriptors.find(child) == _descriptors.end()) && (found.insert(child).second == true) ) {
+                                Fork(pid, child);
+                                pending.push_back(child);
+                            }
+                        }
+                    }
+                }
             }
-            Parameter(const Parameter& copy) 
-                : Core::JSON::Container()
-                , Option(copy.Option)
-                , Value(copy.Value) {
-                Add(_T("option"), &Option);
-                Add(_T("value"), &Value);
+            void Fork(const uint32_t parent, const uint32_t child) {
+                proc_event event;
+                ::memset(&event, 0, sizeof(event));
+
+                event.what = proc_event::PROC_EVENT_FORK;
+                event.event_data.fork.parent_pid = parent;
+                event.event_data.fork.parent_tgid = parent;
+                event.event_data.fork.child_pid = child;
+                event.event_data.fork.child_tgid = child;
+                _events.push_back(event);
             }
-            ~Parameter() {
+            void Exit(const uint32_t pid) {
+                proc_event event;
+                ::memset(&event, 0, sizeof(event));
+
+                event.what = proc_event::PROC_EVENT_EXIT;
+                event.event_data.exit.process_pid = pid;
+                event.event_data.exit.process_tgid = pid;
+                _events.push_back(event);
+            }
+            void Report() {
+                // The views can only be created once all events are in place.
+                _batch.clear();
+                for (const proc_event& event : _events) {
+                    _batch.emplace_back(event);
+                }
+                _parent.Received(_batch);
+            }
+            void Close() {
+                if (_timer != -1) {
+                    ::close(_timer);
+                    _timer = -1;
+                }
+                if (_epoll != -1) {
+                    ::close(_epoll);
+                    _epoll = -1;
+                }
             }
 
-        public:
-            Core::JSON::String Option;
-            Core::JSON::String Value;
+        private:
+            ProcessObserver& _parent;
+            int _epoll;
+            int _timer;
+            bool _children;
+            Descriptors _descriptors;
+            std::vector<uint32_t> _gone;
+            std::vector<proc_event> _events;
+            Batch _batch;
         };
 
     public:
-        class Schedule : public Core::JSON::Container {
+        struct IProcessState {
+            virtual ~IProcessState() {}
+
+            virtual void Update(const Info&) = 0;
+
+            // Events for this observer got lost, its administration needs to be rebuilt from the system.
+            virtual void Resync() = 0;
+
+            // Not reported by the observer, but by a job that saw a run end before its exit could be
+            // collected, it is to be looked at again.
+            virtual void Reap() = 0;
+        };
+
+    private:
+        // Bounded, lock free, single producer/single consumer queue. The producer is the channel
+        // thread, the consumer is the job draining it on the workerpool.
+        template <typename ELEMENT, const uint32_t CAPACITY>
+        class QueueType {
         private:
-            Schedule& operator=(const Schedule&) = delete;
+            static_assert((CAPACITY & (CAPACITY - 1)) == 0, "The capacity of the queue must be a power of 2");
 
         public:
-            Schedule()
-                : Core::JSON::Container()
-                , Mode(RELATIVE)
-                , Time()
-                , Interval() {
-                Add(_T("mode"), &Mode);
-                Add(_T("time"), &Time);
-                Add(_T("interval"), &Interval);
+            QueueType(const QueueType<ELEMENT, CAPACITY>&) = delete;
+            QueueType<ELEMENT, CAPACITY>& operator=(const QueueType<ELEMENT, CAPACITY>&) = delete;
+
+            QueueType()
+                : _head(0)
+                , _tail(0) {
             }
-            Schedule(const Schedule& copy)
-                : Core::JSON::Container()
-                , Mode(copy.Mode)
-                , Time(copy.Time)
-                , Interval(copy.Interval) {
-                Add(_T("mode"), &Mode);
-                Add(_T("time"), &Time);
-                Add(_T("interval"), &Interval);
+            ~QueueType() = default;
+
+        public:
+            bool IsEmpty() const {
+                return (_head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire));
             }
-            ~Schedule() {
+            bool Push(const ELEMENT& element) {
+                const uint32_t tail = _tail.load(std::memory_order_relaxed);
+                bool pushed = ((tail - _head.load(std::memory_order_acquire)) < CAPACITY);
+
+                if (pushed == true) {
+                    _slots[tail & (CAPACITY - 1)] = element;
+                    _tail.store(tail + 1, std::memory_order_release);
+                }
+                return (pushed);
+            }
+            bool Pop(ELEMENT& element) {
+                const uint32_t head = _head.load(std::memory_order_relaxed);
+                bool popped = (head != _tail.load(std::memory_order_acquire));
+
+                if (popped == true) {
+                    element = _slots[head & (CAPACITY - 1)];
+                    _head.store(head + 1, std::memory_order_release);
+                }
+                return (popped);
+            }
+
+        private:
+            std::atomic<uint32_t> _head;
+            std::atomic<uint32_t> _tail;
+            ELEMENT _slots[CAPACITY];
+        };
+
+        class Consumer {
+        private:
+            static constexpr uint32_t QueueSize = 512;
+
+        public:
+            Consumer() = delete;
+            Consumer(const Consumer&) = delete;
+            Consumer& operator=(const Consumer&) = delete;
+
+            Consumer(IProcessState* callback)
+                : _callback(callback)
+                , _scheduled(false)
+                , _resync(false)
+                , _queue()
+                , _job(*this) {
+            }
+            ~Consumer() {
+                _job.Revoke();
             }
+
         public:
-            Core::JSON::EnumType<mode> Mode;
-            Core::JSON::String Time;
-            Core::JSON::String Interval;
+            bool Is(const IProcessState* callback) const {
+                return (_callback.load(std::memory_order_relaxed) == callback);
+            }
+            // Only called from the channel thread, never blocks. If the queue is full, the event is
+            // dropped and the consumer will resync once it caught up with what is queued.
+            bool Push(const proc_event& event) {
+                const bool pushed = _queue.Push(event);
+
+                if (pushed == false) {
+                    _resync.store(true, std::memory_order_release);
+                }
+                Schedule();
+
+                return (pushed);
+            }
+            void Resync() {
+                _resync.store(true, std::memory_order_release);
+                Schedule();
+            }
+            // Once detached, the callback is never called again, also not by a drain that is still queued.
+            void Detach() {
+                _callback.store(nullptr, std::memory_order_release);
+                _job.Revoke();
+            }
+
+        private:
+            void Schedule() {
+                if (_scheduled.exchange(true, std::memory_order_acq_rel) == false) {
+                    _job.Submit();
+                }
+            }
+
+            friend Core::ThreadPool::JobType<Consumer&>;
+            void Dispatch() {
+                proc_event event;
+
+                _scheduled.store(false, std::memory_order_release);
+
+                while (_queue.Pop(event) == true) {
+                    IProcessState* callback = _callback.load(std::memory_order_acquire);
+
+                    if (callback != nullptr) {
+                        callback->Update(Info(event));
+                    }
+                }
+
+                if (_resync.exchange(false, std::memory_order_acq_rel) == true) {
+                    IProcessState* callback = _callback.load(std::memory_order_acquire);
+
+                    if (callback != nullptr) {
+                        callback->Resync();
+                    }
+                }
+            }
+
+        private:
+            std::atomic<IProcessState*> _callback;
+            std::atomic<bool> _scheduled;
+            std::atomic<bool> _resync;
+            QueueType<proc_event, QueueSize> _queue;
+            Core::WorkerPool::JobType<Consumer&> _job;
+        };
+
+        typedef std::vector< std::shared_ptr<Consumer> > Consumers;
+        typedef std::unordered_map<uint32_t, std::shared_ptr<Consumer> > ProcessMap;
+
+        // Changes to the process table requested by other threads. They are applied by the channel
+        // thread, which is the only one touching the table, before it handles the next event.
+        struct Request {
+            enum type {
+                TRACK,
+                UNTRACK,
+                FORGET
+            };
+
+            type Type;
+            uint32_t Pid;
+            std::shared_ptr<Consumer> Owner;
         };
 
     public:
-        Config()
-            : Core::JSON::Container()
-            , Command()
-            , Parameters()
-            , CloseTime(3)
-            , ScheduleTime()
-        {
-            Add(_T("command"), &Command);
-            Add(_T("parameters"), &Parameters);
-            Add(_T("closetime"), &CloseTime);
-            Add(_T("schedule"), &ScheduleTime);
+        ProcessObserver(const backend type)
+            : _adminLock()
+            , _channel(*this)
+            , _pidChannel(*this)
+            , _source(type == PIDFD ? static_cast<ISource&>(_pidChannel) : static_cast<ISource&>(_channel))
+            , _consumers(std::make_shared<const Consumers>())
+            , _processes()
+            , _requests()
+            , _requested(false)
+            , _lost(0) {
         }
-        ~Config()
-        {
+        ~ProcessObserver() {
+            ASSERT(std::atomic_load(&_consumers)->empty());
+            ASSERT(_processes.empty());
         }
 
     public:
-        Core::JSON::String Command;
-        Core::JSON::ArrayType<Parameter> Parameters;
-        Core::JSON::DecUInt8 CloseTime;
-        Schedule ScheduleTime;
+        // Registration replaces the list of consumers by an updated copy, so whoever reads the
+        // list never needs to synchronize with a (un)registration.
+        void Register(IProcessState* observer) {
+            _adminLock.Lock();
+
+            std::shared_ptr<const Consumers> current(std::atomic_load(&_consumers));
+            ASSERT (Find(*current, observer) == nullptr);
+
+            if (current->empty()) {
+                const bool opened = Open();
+                DEBUG_VARIABLE(opened);
+                ASSERT(opened);
+            }
+
+            std::shared_ptr<Consumers> updated(std::make_shared<Consumers>(*current));
+            updated->push_back(std::make_shared<Consumer>(observer));
+            std::atomic_store(&_consumers, std::shared_ptr<const Consumers>(updated));
+
+            _adminLock.Unlock();
+        }
+        void Unregister(IProcessState* observer) {
+            _adminLock.Lock();
+
+            std::shared_ptr<const Consumers> current(std::atomic_load(&_consumers));
+            std::shared_ptr<Consumer> consumer(Find(*current, observer));
+            ASSERT(consumer != nullptr);
+
+            std::shared_ptr<Consumers> updated(std::make_shared<Consumers>());
+            for (const std::shared_ptr<Consumer>& entry : *current) {
+                if (entry != consumer) {
+                    updated->push_back(entry);
+                }
+            }
+            std::atomic_store(&_consumers, std::shared_ptr<const Consumers>(updated));
+
+            if (updated->empty()) {
+                Close();
+
+                // The channel is down, so nobody else is touching the process table anymore.
+                _processes.clear();
+                _requests.clear();
+                _requested.store(false, std::memory_order_release);
+            }
+            else {
+                // Drop whatever is still tracked on behalf of this observer, it will not be reported anymore.
+                Post(Request::FORGET, 0, consumer);
+            }
+
+            _adminLock.Unlock();
+
+            consumer->Detach();
+        }
+        // Start reporting the events of this process, and of all its descendants, to the owner. 
+        // Children are added when they are forked and all entries are removed on their exit, 
+        // so only the root process of a tree needs to be tracked explicitly.
+        void Track(const uint32_t pid, IProcessState* owner) {
+            _adminLock.Lock();
+            std::shared_ptr<Consumer> consumer(Find(*std::atomic_load(&_consumers), owner));
+            ASSERT (consumer != nullptr);
+            Post(Request::TRACK, pid, consumer);
+            _adminLock.Unlock();
+        }
+        void Untrack(const uint32_t pid) {
+            _adminLock.Lock();
+            Post(Request::UNTRACK, pid, std::shared_ptr<Consumer>());
+            _adminLock.Unlock();
+        }
+        // Number of events that did not make it to the Jobs, either dropped by the kernel because
+        // the socket overran, or dropped because a consumer could not keep up.
+        uint32_t Lost() const {
+            return (_lost.load(std::memory_order_relaxed));
+        }
+
+    private:
+        static std::shared_ptr<Consumer> Find(const Consumers& consumers, const IProcessState* observer) {
+            for (const std::shared_ptr<Consumer>& entry : consumers) {
+                if (entry->Is(observer) == true) {
+                    return (entry);
+                }
+            }
+            return (std::shared_ptr<Consumer>());
+        }
+        void Post(const Request::type type, const uint32_t pid, const std::shared_ptr<Consumer>& owner) {
+            _requests.push_back({ type, pid, owner });
+            _requested.store(true, std::memory_order_release);
+        }
+        bool Open() {
+            return (_source.Start());
+        }
+        bool Close() {
+            _source.Stop();
+
+            return (Core::ERROR_NONE);
+        }
+
+    private:
+        void Apply() {
+            std::vector<Request> requests;
+
+            _adminLock.Lock();
+            requests.swap(_requests);
+            _requested.store(false, std::memory_order_release);
+            _adminLock.Unlock();
+
+            for (const Request& request : requests) {
+                switch (request.Type) {
+                case Request::TRACK:
+                    _processes[request.Pid] = request.Owner;
+                    _source.Watch(request.Pid);
+                    break;
+                case Request::UNTRACK:
+                    _processes.erase(request.Pid);
+                    _source.Unwatch(request.Pid);
+                    break;
+                case Request::FORGET:
+                {
+                    ProcessMap::iterator index(_processes.begin());
+                    while (index != _processes.end()) {
+                        if (index->second == request.Owner) {
+                            _source.Unwatch(index->first);
+                            index = _processes.erase(index);
+                        }
+                        else {
+                            index++;
+                        }
+                    }
+                    break;
+                }
+                }
+            }
+        }
+        // Runs on the channel thread. Nothing in here waits for any plugin, the events are only
+        // queued for the owning consumer, which processes them on the workerpool.
+        void Received (const Batch& batch) {
+            if (_requested.load(std::memory_order_acquire) == true) {
+                Apply();
+            }
+
+            for (const Info& info : batch) {
+                Received(info);
+            }
+        }
+        // The kernel could not deliver all events, so none of the trees can be trusted anymore.
+        void Overrun (const uint32_t lost) {
+            _lost.fetch_add(lost, std::memory_order_relaxed);
+
+            TRACE(Trace::Warning, (_T("Lost %d process events, resyncing all process trees."), lost));
+
+            std::shared_ptr<const Consumers> consumers(std::atomic_load(&_consumers));
+            for (const std::shared_ptr<Consumer>& consumer : *consumers) {
+                consumer->Resync();
+            }
+        }
+        void Push (Consumer& consumer, const Info& info) {
+            if (consumer.Push(info.Data()) == false) {
+                _lost.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        void Received (const Info& info) {
+            switch (info.Event()) {
+            case Info::EVENT_FORK:
+            {
+                ProcessMap::const_iterator index(_processes.find(info.Group()));
+                if (index != _processes.end()) {
+                    std::shared_ptr<Consumer> owner(index->second);
+                    _processes[info.ChildId()] = owner;
+                    _source.Watch(info.ChildId());
+                    Push(*owner, info);
+                }
+                break;
+            }
+            case Info::EVENT_EXIT:
+            {
+                ProcessMap::iterator index(_processes.find(info.Id()));
+                if (index != _processes.end()) {
+                    Push(*(index->second), info);
+                    _processes.erase(index);
+                    _source.Unwatch(info.Id());
+                }
+                break;
+            }
+            case Info::EVENT_NONE:
+                break;
+            default:
+            {
+                ProcessMap::const_iterator index(_processes.find(info.Id()));
+                if (index != _processes.end()) {
+                    Push(*(index->second), info);
+                }
+                break;
+            }
+            }
+        }
+
+    private:
+        Core::CriticalSection _adminLock;
+        Channel _channel;
+        PidChannel _pidChannel;
+        ISource& _source;
+        std::shared_ptr<const Consumers> _consumers;
+        ProcessMap _processes;
+        std::vector<Request> _requests;
+        std::atomic<bool> _requested;
+        std::atomic<uint32_t> _lost;
     };
 
+    class Notification : public ProcessObserver::IProcessState {
     private:
-    class Time {
+        Notification() = delete;
+        Notification(const Notification&) = delete;
+
     public:
-        Time()
-        : _hour(~0)
-        , _minute(~0)
-        , _second(~0) {
+        explicit Notification(Launcher* parent)
+            : _parent(*parent)
+        {
+            ASSERT(parent != nullptr);
         }
-        Time(const string& time) 
-        : _hour(~0) 
-        , _minute(~0)
-        , _second(~0) {
-            Parse(time);
+        ~Notification() override = default;
+
+    public:
+        void Update(const ProcessObserver::Info& info) override {
+            _parent.Update(info);
         }
-        Time(const Time& copy) 
-        : _hour(copy._hour) 
-        , _minute(copy._minute)
-        , _second(copy._second) {
+        void Resync() override {
+            _parent.Resync();
+        }
+        void Reap() override {
+            _parent.Reap();
         }
-        ~Time () = default;
 
-        Time& operator= (const Time& rhs) {
-            _hour = rhs._hour; 
-            _minute = rhs._minute;
-            _second = rhs._second;
+    private:
+        Launcher& _parent;
+    };
 
-            return (*this);
+    // What processes cost, as far as it is known of them.
+    struct Usage {
+        uint64_t User; // us
+        uint64_t System; // us
+        uint64_t MaxResident; // KiB, of the largest process
+        uint64_t Read; // bytes
+        uint64_t Written; // bytes
+        uint64_t Voluntary; // context switches
+        uint64_t Involuntary; // context switches
+
+        void Add(const struct rusage& usage) {
+            User += (static_cast<uint64_t>(usage.ru_utime.tv_sec) * 1000000) + usage.ru_utime.tv_usec;
+            System += (static_cast<uint64_t>(usage.ru_stime.tv_sec) * 1000000) + usage.ru_stime.tv_usec;
+            MaxResident = std::max(MaxResident, static_cast<uint64_t>(usage.ru_maxrss));
+            // Counted in blocks of 512 bytes.
+            Read += static_cast<uint64_t>(usage.ru_inblock) * 512;
+            Written += static_cast<uint64_t>(usage.ru_oublock) * 512;
+            Voluntary += usage.ru_nvcsw;
+            Involuntary += usage.ru_nivcsw;
         }
+        void Add(const Usage& usage) {
+            User += usage.User;
+            System += usage.System;
+            MaxResident = std::max(MaxResident, usage.MaxResident);
+            Read += usage.Read;
+            Written += usage.Written;
+            Voluntary += usage.Voluntary;
+            Involuntary += usage.Involuntary;
+        }
+    };
 
-        static constexpr uint32_t MilliSecondsPerSecond = 1000;
-        static constexpr uint32_t SecondsPerMinute = 60;
-        static constexpr uint32_t MinutesPerHour = 60;
-        static constexpr uint32_t HoursPerDay = 24;
+    // A cgroup v2 leaf holding everything a Job launched. Processes can not escape from it, so
+    // killing or accounting for a whole tree is a single file access, whatever its size.
+    class ControlGroup : public Core::IResource {
+    public:
+        struct ICallback {
+            virtual ~ICallback() {}
+
+            // The populated state of the group might have changed.
+            virtual void Changed() = 0;
+        };
 
     public:
-        bool IsValid () const { return (HasSeconds() || HasMinutes() || HasHours()); }
-        bool HasHours() const { return (_hour < HoursPerDay); }
-        bool HasMinutes() const { return (_minute < MinutesPerHour); }
-        bool HasSeconds() const { return (_second < SecondsPerMinute); }
-        uint8_t Hours() const { return _hour; }
-        uint8_t Minutes() const { return _minute; }
-        uint8_t Seconds() const { return _second; }
-        uint32_t TimeInSeconds() const {
-            return ( (HasHours() ? Hours() : 0) * MinutesPerHour * SecondsPerMinute + 
-                     (HasMinutes() ? Minutes() : 0) * SecondsPerMinute + 
-                      Seconds() );
+        ControlGroup() = delete;
+        ControlGroup(const ControlGroup&) = delete;
+        ControlGroup& operator=(const ControlGroup&) = delete;
+
+        ControlGroup(const string& path, ICallback* callback)
+            : _path(path)
+            , _callback(callback)
+            , _inotify(-1)
+        {
+        }
+        ~ControlGroup() override
+        {
+            Close();
+        }
+
+    public:
+        bool IsValid() const {
+            return (_path.empty() == false);
+        }
+        const string& Path() const {
+            return (_path);
+        }
+        bool IsOpen() const {
+            return (_inotify != -1);
+        }
+        uint32_t Open() {
+            uint32_t result = Core::ERROR_NONE;
+
+            if (IsValid() == true) {
+                string parent(_path.substr(0, _path.find_last_of('/')));
+
+                // Best effort, without these controllers there is no memory accounting or no limits.
+                // One by one, a single write enabling them all fails if any of them is unavailable.
+                for (const TCHAR* controller : { _T("+memory"), _T("+cpu"), _T("+io") }) {
+                    if (Write(parent + _T("/cgroup.subtree_control"), controller) == false) {
+                        TRACE(Trace::Warning, (_T("Could not enable controller %s for %s, error: %d."), &(controller[1]), parent.c_str(), errno));
+                    }
+                }
+
+                if ((::mkdir(_path.c_str(), 0755) != 0) && (errno != EEXIST)) {
+                    TRACE(Trace::Error, (_T("Could not create control group %s, error: %d."), _path.c_str(), errno));
+                    result = Core::ERROR_UNAVAILABLE;
+                }
+                else if ((_inotify = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) == -1) {
+                    result = Core::ERROR_UNAVAILABLE;
+                }
+                else if (::inotify_add_watch(_inotify, (_path + _T("/cgroup.events")).c_str(), IN_MODIFY) == -1) {
+                    TRACE(Trace::Error, (_T("Control group %s is not a cgroup v2 group, error: %d."), _path.c_str(), errno));
+                    ::close(_inotify);
+                    _inotify = -1;
+                    ::rmdir(_path.c_str());
+                    result = Core::ERROR_UNAVAILABLE;
+                }
+                else {
+                    Core::ResourceMonitor::Instance().Register(*this);
+                }
+            }
+
+            return (result);
+        }
+        void Close() {
+            if (_inotify != -1) {
+                Core::ResourceMonitor::Instance().Unregister(*this);
+                ::close(_inotify);
+                _inotify = -1;
+
+                // Only succeeds if nothing is left in there.
+                if (::rmdir(_path.c_str()) != 0) {
+                    TRACE(Trace::Error, (_T("Could not remove control group %s, error: %d."), _path.c_str(), errno));
+                }
+            }
+        }
+        // Caps the CPU bandwidth and/or the block I/O of the group, if the controllers are enabled for it.
+        bool Limit(const string& cpu, const std::vector<string>& io) const {
+            bool result = ((cpu.empty() == true) || (Write(_path + _T("/cpu.max"), cpu) == true));
+
+            for (const string& device : io) {
+                result = (Write(_path + _T("/io.max"), device) == true) && result;
+            }
+
+            return (result);
+        }
+        // Writing a 0 in here moves the writer into the group.
+        int Procs() const {
+            return (::open((_path + _T("/cgroup.procs")).c_str(), O_WRONLY | O_CLOEXEC));
+        }
+        void Kill() {
+            // Only available as of Linux 5.14, before that, do it one by one.
+            if (Write(_path + _T("/cgroup.kill"), _T("1")) == false) {
+                std::vector<uint32_t> pids;
+
+                Pids(pids);
+
+                for (const uint32_t pid : pids) {
+                    ::kill(pid, SIGKILL);
+                }
+            }
+        }
+        // Adds the processes in the group to the list.
+        void Pids(std::vector<uint32_t>& pids) const {
+            string list;
+
+            if (Read(_path + _T("/cgroup.procs"), list) == true) {
+                const char* entry = list.c_str();
+                char* end;
+
+                while (*entry != '\0') {
+                    uint32_t pid = static_cast<uint32_t>(::strtoul(entry, &end, 10));
+                    if (end == entry) {
+                        break;
+                    }
+                    pids.push_back(pid);
+                    entry = end;
+                }
+            }
+        }
+        bool Populated() const {
+            return (Value(_T("cgroup.events"), _T("populated")) != 0);
+        }
+        uint8_t Processes() const {
+            string list;
+            uint32_t count = 0;
+
+            if (Read(_path + _T("/cgroup.procs"), list) == true) {
+                count = static_cast<uint32_t>(std::count(list.begin(), list.end(), '\n'));
+            }
+            return (count > 0xFF ? 0xFF : static_cast<uint8_t>(count));
+        }
+        uint64_t Memory() const {
+            string value;
+            return (Read(_path + _T("/memory.current"), value) == true ? ::strtoull(value.c_str(), nullptr, 10) : 0);
+        }
+        uint64_t Anonymous() const {
+            return (Value(_T("memory.stat"), _T("anon")));
+        }
+        uint64_t Shared() const {
+            return (Value(_T("memory.stat"), _T("shmem")) + Value(_T("memory.stat"), _T("file_mapped")));
+        }
+        // The CPU time and the block I/O of all processes that were ever in the group, the I/O only
+        // if the io controller is enabled for it.
+        void Consumed(Usage& usage) const {
+            string content;
+
+            usage.User = Value(_T("cpu.stat"), _T("user_usec"));
+            usage.System = Value(_T("cpu.stat"), _T("system_usec"));
+
+            if (Read(_path + _T("/io.stat"), content) == true) {
+                usage.Read = Sum(content, _T("rbytes="));
+                usage.Written = Sum(content, _T("wbytes="));
+            }
+        }
+
+    private:
+        handle Descriptor() const override {
+            return (_inotify);
+        }
+        uint16_t Events() override {
+            return (POLLIN);
+        }
+        void Handle(const uint16_t /* events */) override {
+            uint8_t buffer[sizeof(struct inotify_event) + NAME_MAX + 1];
+
+            // Drain it, we are only interested in the fact that something changed.
+            while (::read(_inotify, buffer, sizeof(buffer)) > 0) {
+            }
+
+            _callback->Changed();
+        }
+        // Sums the "key=value" pairs of all lines in a nested keyed file.
+        static uint64_t Sum(const string& content, const TCHAR key[]) {
+            const size_t length = ::strlen(key);
+            uint64_t result = 0;
+            size_t position = content.find(key);
+
+            while (position != string::npos) {
+                result += ::strtoull(&(content[position + length]), nullptr, 10);
+                position = content.find(key, position + length);
+            }
+
+            return (result);
+        }
+        // Lookup a "key value" line in one of the flat keyed files of the group.
+        uint64_t Value(const TCHAR file[], const TCHAR key[]) const {
+            uint64_t result = 0;
+            string content;
+
+            if (Read(_path + '/' + file, content) == true) {
+                const size_t length = ::strlen(key);
+                size_t position = 0;
+
+                while (position < content.length()) {
+                    if ((content.compare(position, length, key) == 0) && (content[position + length] == ' ')) {
+                        result = ::strtoull(&(content[position + length + 1]), nullptr, 10);
+                        break;
+                    }
+                    position = content.find('\n', position);
+                    position = (position == string::npos ? string::npos : position + 1);
+                }
+            }
+
+            return (result);
+        }
+        static bool Read(const string& file, string& content) {
+            int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+            bool result = (fd != -1);
+
+            content.clear();
+
+            if (result == true) {
+                char buffer[512];
+                ssize_t length;
+
+                while ((length = ::read(fd, buffer, sizeof(buffer))) > 0) {
+                    content.append(buffer, length);
+                }
+                ::close(fd);
+            }
+
+            return (result);
+        }
+        static bool Write(const string& file, const string& content) {
+            int fd = ::open(file.c_str(), O_WRONLY | O_CLOEXEC);
+            bool result = false;
+
+            if (fd != -1) {
+                result = (::write(fd, content.c_str(), content.length()) == static_cast<ssize_t>(content.length()));
+                ::close(fd);
+            }
+
+            return (result);
+        }
+
+    private:
+        const string _path;
+        ICallback* _callback;
+        int _inotify;
+    };
+
+    // Accounts for the memory of all processes of the Job. The monitor polls us frequently, so the
+    // processes are sampled by a job, and the callers only ever get the result of the last sample.
+    // Proportional figures (PSS/USS) are far more expensive to get, these are sampled less often.
+    class MemoryObserverImpl : public Exchange::IMemory {
+    private:
+        MemoryObserverImpl(const MemoryObserverImpl&);
+        MemoryObserverImpl& operator=(const MemoryObserverImpl&);
+
+        struct Sample {
+            uint64_t Allocated;
+            uint64_t Resident;
+            uint64_t Shared;
+            uint64_t Taken;
+        };
+        typedef std::unordered_map<uint32_t, Sample> Samples;
+
+        static constexpr uint32_t RefreshPeriod = 1000; // ms
+
+    public:
+        MemoryObserverImpl()
+            : _adminLock()
+            , _samples()
+            , _total({ 0, 0, 0, 0 })
+            , _pageSize(::sysconf(_SC_PAGESIZE))
+            , _groups()
+            , _accounting(STATM)
+            , _period(RefreshPeriod)
+            , _running(false)
+            , _sampling(false)
+            , _sampler(*this)
+        {
+        }
+        ~MemoryObserverImpl()
+        {
+            _sampler.Revoke();
+        }
+
+    public:
+        // Period in seconds, the proportional figures are sampled at this rate.
+        void Configure(const accounting type, const uint16_t period)
+        {
+            _adminLock.Lock();
+
+            _accounting = type;
+            _period = (type == PROPORTIONAL ? (period == 0 ? 1 : period) * Time::MilliSecondsPerSecond : RefreshPeriod);
+            _running = true;
+
+            const bool start = Start();
+
+            _adminLock.Unlock();
+
+            if (start == true) {
+                _sampler.Submit();
+            }
+        }
+        void Stop()
+        {
+            _adminLock.Lock();
+            _running = false;
+            _adminLock.Unlock();
+
+            _sampler.Revoke();
+        }
+        // Called by the Job for every process that joins or leaves its tree. It counts as of the next sample.
+        void Add(const uint32_t pid)
+        {
+            _adminLock.Lock();
+            _samples.emplace(pid, Sample { 0, 0, 0, 0 });
+            const bool start = Start();
+            _adminLock.Unlock();
+
+            if (start == true) {
+                _sampler.Submit();
+            }
+        }
+        void Remove(const uint32_t pid)
+        {
+            _adminLock.Lock();
+
+            Samples::iterator index(_samples.find(pid));
+
+            if (index != _samples.end()) {
+                Subtract(index->second);
+                _samples.erase(index);
+            }
+
+            _adminLock.Unlock();
+        }
+        void Clear()
+        {
+            _adminLock.Lock();
+            _samples.clear();
+            _total = { 0, 0, 0, 0 };
+            _adminLock.Unlock();
+        }
+        // If the processes are contained in control groups, the groups account for all of them.
+        void Observe(const ControlGroup* group)
+        {
+            _adminLock.Lock();
+            _groups.push_back(group);
+            _adminLock.Unlock();
+        }
+        void Forget(const ControlGroup* group)
+        {
+            _adminLock.Lock();
+            _groups.erase(std::remove(_groups.begin(), _groups.end(), group), _groups.end());
+            _adminLock.Unlock();
+        }
+        virtual uint64_t Resident() const
+        {
+            Core::SafeSyncType<Core::CriticalSection> scopedLock(_adminLock);
+            return (_groups.empty() == false ? Sum(&ControlGroup::Memory) : _total.Resident);
+        }
+        virtual uint64_t Allocated() const
+        {
+            Core::SafeSyncType<Core::CriticalSection> scopedLock(_adminLock);
+            return (_groups.empty() == false ? Sum(&ControlGroup::Anonymous) : _total.Allocated);
+        }
+        virtual uint64_t Shared() const
+        {
+            Core::SafeSyncType<Core::CriticalSection> scopedLock(_adminLock);
+            return (_groups.empty() == false ? Sum(&ControlGroup::Shared) : _total.Shared);
+        }
+        virtual uint8_t Processes() const
+        {
+            Core::SafeSyncType<Core::CriticalSection> scopedLock(_adminLock);
+            uint32_t count = static_cast<uint32_t>(_samples.size());
+
+            if (_groups.empty() == false) {
+                count = 0;
+                for (const ControlGroup* group : _groups) {
+                    count += group->Processes();
+                }
+            }
+            return (count > 0xFF ? 0xFF : static_cast<uint8_t>(count));
+        }
+        virtual bool IsOperational() const
+        {
+            // In between two runs, there is nothing to observe, which is fine.
+            return (true);
+        }
+
+        BEGIN_INTERFACE_MAP(MemoryObserverImpl)
+        INTERFACE_ENTRY(Exchange::IMemory)
+        END_INTERFACE_MAP
+
+    private:
+        string JobIdentifier() const
+        {
+            return (_T("Launcher::MemoryObserver"));
+        }
+
+        // Called with the lock taken, returns true if the sampler is to be started, it is
+        // only running while there are processes to sample.
+        bool Start()
+        {
+            const bool result = ((_running == true) && (_sampling == false) && (_samples.empty() == false));
+
+            if (result == true) {
+                _sampling = true;
+            }
+
+            return (result);
+        }
+
+        friend Core::ThreadPool::JobType<MemoryObserverImpl&>;
+        void Dispatch()
+        {
+            std::vector< std::pair<uint32_t, Sample> > samples;
+            Core::Time nextRun(Core::Time::Now());
+
+            _adminLock.Lock();
+            const accounting type = _accounting;
+            samples.reserve(_samples.size());
+            for (const std::pair<const uint32_t, Sample>& entry : _samples) {
+                samples.emplace_back(entry.first, Sample { 0, 0, 0, nextRun.Ticks() });
+            }
+            _adminLock.Unlock();
+
+            // No lock held while reading, this takes a while for big processes.
+            for (std::pair<uint32_t, Sample>& entry : samples) {
+                if (type == PROPORTIONAL) {
+                    Proportional(entry.first, entry.second);
+                }
+                else {
+                    Read(entry.first, entry.second);
+                }
+            }
+
+            _adminLock.Lock();
+
+            // Processes that left in the mean time, are not counted anymore.
+            for (const std::pair<uint32_t, Sample>& entry : samples) {
+                Samples::iterator index(_samples.find(entry.first));
+
+                if (index != _samples.end()) {
+                    Subtract(index->second);
+                    index->second = entry.second;
+                    _total.Allocated += entry.second.Allocated;
+                    _total.Resident += entry.second.Resident;
+                    _total.Shared += entry.second.Shared;
+                }
+            }
+
+            _sampling = ((_running == true) && (_samples.empty() == false));
+            const bool reschedule = _sampling;
+            nextRun.Add(_period);
+
+            _adminLock.Unlock();
+
+            if (reschedule == true) {
+                _sampler.Reschedule(nextRun);
+            }
+        }
+        // Resident becomes the PSS, Allocated the USS and Shared the proportional part of the shared pages.
+        static void Proportional(const uint32_t pid, Sample& sample)
+        {
+            char path[48];
+
+            ::snprintf(path, sizeof(path), "/proc/%u/smaps_rollup", pid);
+
+            FILE* file = ::fopen(path, "re");
+
+            if (file != nullptr) {
+                char line[128];
+                unsigned long long value;
+                uint64_t pss = 0;
+                uint64_t uss = 0;
+
+                while (::fgets(line, sizeof(line), file) != nullptr) {
+                    if (::sscanf(line, "Pss: %llu kB", &value) == 1) {
+                        pss = value * 1024;
+                    }
+                    else if ((::sscanf(line, "Private_Clean: %llu kB", &value) == 1) || (::sscanf(line, "Private_Dirty: %llu kB", &value) == 1)) {
+                        uss += value * 1024;
+                    }
+                }
+                ::fclose(file);
+
+                sample.Resident += pss;
+                sample.Allocated += uss;
+                sample.Shared += (pss > uss ? pss - uss : 0);
+            }
+        }
+        uint64_t Sum(uint64_t (ControlGroup::*property)() const) const
+        {
+            uint64_t result = 0;
+
+            for (const ControlGroup* group : _groups) {
+                result += (group->*property)();
+            }
+
+            return (result);
+        }
+        void Subtract(const Sample& sample)
+        {
+            _total.Allocated -= sample.Allocated;
+            _total.Resident -= sample.Resident;
+            _total.Shared -= sample.Shared;
+        }
+        // A process that is already gone, but not yet removed, counts for nothing.
+        void Read(const uint32_t pid, Sample& sample) const
+        {
+            char path[32];
+
+            ::snprintf(path, sizeof(path), "/proc/%u/statm", pid);
+
+            int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+
+            if (fd >= 0) {
+                char buffer[128];
+                ssize_t length = ::read(fd, buffer, sizeof(buffer) - 1);
+
+                if (length > 0) {
+                    unsigned long long size, resident, shared;
+
+                    buffer[length] = '\0';
+
+                    if (::sscanf(buffer, "%llu %llu %llu", &size, &resident, &shared) == 3) {
+                        sample.Allocated = size * _pageSize;
+                        sample.Resident = resident * _pageSize;
+                        sample.Shared = shared * _pageSize;
+                    }
+                }
+                ::close(fd);
+            }
+        }
+
+    private:
+        mutable Core::CriticalSection _adminLock;
+        Samples _samples;
+        Sample _total;
+        const uint64_t _pageSize;
+        std::vector<const ControlGroup*> _groups;
+        accounting _accounting;
+        uint32_t _period; // ms
+        bool _running;
+        bool _sampling;
+
+        Core::WorkerPool::JobType<MemoryObserverImpl&> _sampler;
+    };
+
+public:
+    class Config : public Core::JSON::Container {
+    private:
+        Config(const Config&) = delete;
+        Config& operator=(const Config&) = delete;
+
+    public:
+        class Parameter : public Core::JSON::Container {
+        private:
+            Parameter& operator=(const Parameter&) = delete;
+
+        public:
+            Parameter()
+                : Core::JSON::Container()
+                , Option()
+                , Value() {
+                Add(_T("option"), &Option);
+                Add(_T("value"), &Value);
+            }
+            Parameter(const Parameter& copy) 
+                : Core::JSON::Container()
+                , Option(copy.Option)
+                , Value(copy.Value) {
+                Add(_T("option"), &Option);
+                Add(_T("value"), &Value);
+            }
+            ~Parameter() {
+            }
+
+        public:
+            Core::JSON::String Option;
+            Core::JSON::String Value;
+        };
+
+    public:
+        class Memory : public Core::JSON::Container {
+        private:
+            Memory& operator=(const Memory&) = delete;
+
+        public:
+            Memory()
+                : Core::JSON::Container()
+                , Accounting(STATM)
+                , Period(5) {
+                Add(_T("accounting"), &Accounting);
+                Add(_T("period"), &Period);
+            }
+            Memory(const Memory& copy)
+                : Core::JSON::Container()
+                , Accounting(copy.Accounting)
+                , Period(copy.Period) {
+                Add(_T("accounting"), &Accounting);
+                Add(_T("period"), &Period);
+            }
+            ~Memory() {
+            }
+        public:
+            Core::JSON::EnumType<accounting> Accounting;
+            Core::JSON::DecUInt16 Period;
+        };
+
+    public:
+        class Schedule : public Core::JSON::Container {
+        private:
+            Schedule& operator=(const Schedule&) = delete;
+
+        public:
+            Schedule()
+                : Core::JSON::Container()
+                , Mode(RELATIVE)
+                , Time()
+                , Interval()
+                , Splay(0)
+                , CatchUp(SKIP) {
+                Add(_T("mode"), &Mode);
+                Add(_T("time"), &Time);
+                Add(_T("interval"), &Interval);
+                Add(_T("splay"), &Splay);
+                Add(_T("catchup"), &CatchUp);
+            }
+            Schedule(const Schedule& copy)
+                : Core::JSON::Container()
+                , Mode(copy.Mode)
+                , Time(copy.Time)
+                , Interval(copy.Interval)
+                , Splay(copy.Splay)
+                , CatchUp(copy.CatchUp) {
+                Add(_T("mode"), &Mode);
+                Add(_T("time"), &Time);
+                Add(_T("interval"), &Interval);
+                Add(_T("splay"), &Splay);
+                Add(_T("catchup"), &CatchUp);
+            }
+            ~Schedule() {
+            }
+        public:
+            Core::JSON::EnumType<mode> Mode;
+            Core::JSON::String Time;
+            Core::JSON::String Interval;
+            Core::JSON::DecUInt32 Splay;
+            Core::JSON::EnumType<catchup> CatchUp;
+        };
+
+    public:
+        class Step : public Core::JSON::Container {
+        private:
+            Step& operator=(const Step&) = delete;
+
+        public:
+            Step()
+                : Core::JSON::Container()
+                , Signal(TERMINATE)
+                , Target(ROOT)
+                , Timeout(1000) {
+                Add(_T("signal"), &Signal);
+                Add(_T("target"), &Target);
+                Add(_T("timeout"), &Timeout);
+            }
+            Step(const Step& copy)
+                : Core::JSON::Container()
+                , Signal(copy.Signal)
+                , Target(copy.Target)
+                , Timeout(copy.Timeout) {
+                Add(_T("signal"), &Signal);
+                Add(_T("target"), &Target);
+                Add(_T("timeout"), &Timeout);
+            }
+            ~Step() {
+            }
+
+        public:
+            Core::JSON::EnumType<termination> Signal;
+            Core::JSON::EnumType<target> Target;
+            Core::JSON::DecUInt32 Timeout; // ms
+        };
+
+    public:
+        class Output : public Core::JSON::Container {
+        private:
+            Output& operator=(const Output&) = delete;
+
+        public:
+            Output()
+                : Core::JSON::Container()
+                , Buffer(0)
+                , File()
+                , Size(1048576)
+                , Files(2) {
+                Add(_T("buffer"), &Buffer);
+                Add(_T("file"), &File);
+                Add(_T("size"), &Size);
+                Add(_T("files"), &Files);
+            }
+            Output(const Output& copy)
+                : Core::JSON::Container()
+                , Buffer(copy.Buffer)
+                , File(copy.File)
+                , Size(copy.Size)
+                , Files(copy.Files) {
+                Add(_T("buffer"), &Buffer);
+                Add(_T("file"), &File);
+                Add(_T("size"), &Size);
+                Add(_T("files"), &Files);
+            }
+            ~Output() {
+            }
+
+        public:
+            Core::JSON::DecUInt32 Buffer; // bytes
+            Core::JSON::String File;
+            Core::JSON::DecUInt32 Size; // bytes
+            Core::JSON::DecUInt8 Files;
+        };
+
+    public:
+        class Resources : public Core::JSON::Container {
+        private:
+            Resources& operator=(const Resources&) = delete;
+
+        public:
+            Resources()
+                : Core::JSON::Container()
+                , Affinity()
+                , Policy(OTHER)
+                , Nice(0)
+                , IoClass(IO_NONE)
+                , IoLevel(4)
+                , CpuMax()
+                , IoMax() {
+                Add(_T("affinity"), &Affinity);
+                Add(_T("policy"), &Policy);
+                Add(_T("nice"), &Nice);
+                Add(_T("ioclass"), &IoClass);
+                Add(_T("iolevel"), &IoLevel);
+                Add(_T("cpumax"), &CpuMax);
+                Add(_T("iomax"), &IoMax);
+            }
+            Resources(const Resources& copy)
+                : Core::JSON::Container()
+                , Affinity(copy.Affinity)
+                , Policy(copy.Policy)
+                , Nice(copy.Nice)
+                , IoClass(copy.IoClass)
+                , IoLevel(copy.IoLevel)
+                , CpuMax(copy.CpuMax)
+                , IoMax(copy.IoMax) {
+                Add(_T("affinity"), &Affinity);
+                Add(_T("policy"), &Policy);
+                Add(_T("nice"), &Nice);
+                Add(_T("ioclass"), &IoClass);
+                Add(_T("iolevel"), &IoLevel);
+                Add(_T("cpumax"), &CpuMax);
+                Add(_T("iomax"), &IoMax);
+            }
+            ~Resources() {
+            }
+
+        public:
+            // A list of CPUs, like "0-1,3".
+            Core::JSON::String Affinity;
+            Core::JSON::EnumType<policy> Policy;
+            Core::JSON::DecSInt8 Nice;
+            Core::JSON::EnumType<ioclass> IoClass;
+            Core::JSON::DecUInt8 IoLevel;
+            // Written to the files of the control group as is, so "<quota> <period>" and "<major>:<minor> <limits>".
+            Core::JSON::String CpuMax;
+            Core::JSON::ArrayType<Core::JSON::String> IoMax;
+        };
+
+    public:
+        class Pressure : public Core::JSON::Container {
+        private:
+            Pressure& operator=(const Pressure&) = delete;
+
+        public:
+            Pressure()
+                : Core::JSON::Container()
+                , Cpu(0)
+                , Memory(0)
+                , Io(0)
+                , MaxDelay(60) {
+                Add(_T("cpu"), &Cpu);
+                Add(_T("memory"), &Memory);
+                Add(_T("io"), &Io);
+                Add(_T("maxdelay"), &MaxDelay);
+            }
+            Pressure(const Pressure& copy)
+                : Core::JSON::Container()
+                , Cpu(copy.Cpu)
+                , Memory(copy.Memory)
+                , Io(copy.Io)
+                , MaxDelay(copy.MaxDelay) {
+                Add(_T("cpu"), &Cpu);
+                Add(_T("memory"), &Memory);
+                Add(_T("io"), &Io);
+                Add(_T("maxdelay"), &MaxDelay);
+            }
+            ~Pressure() {
+            }
+
+        public:
+            // Percentages of the time some tasks stalled on the resource, 0 does not look at it.
+            Core::JSON::DecUInt8 Cpu;
+            Core::JSON::DecUInt8 Memory;
+            Core::JSON::DecUInt8 Io;
+            Core::JSON::DecUInt16 MaxDelay; // s
+        };
+
+    public:
+        class Supervisor : public Core::JSON::Container {
+        private:
+            Supervisor& operator=(const Supervisor&) = delete;
+
+        public:
+            Supervisor()
+                : Core::JSON::Container()
+                , Policy(NEVER)
+                , Backoff(100)
+                , MaxBackoff(30000)
+                , Retries(5)
+                , Window(60) {
+                Add(_T("policy"), &Policy);
+                Add(_T("backoff"), &Backoff);
+                Add(_T("maxbackoff"), &MaxBackoff);
+                Add(_T("retries"), &Retries);
+                Add(_T("window"), &Window);
+            }
+            Supervisor(const Supervisor& copy)
+                : Core::JSON::Container()
+                , Policy(copy.Policy)
+                , Backoff(copy.Backoff)
+                , MaxBackoff(copy.MaxBackoff)
+                , Retries(copy.Retries)
+                , Window(copy.Window) {
+                Add(_T("policy"), &Policy);
+                Add(_T("backoff"), &Backoff);
+                Add(_T("maxbackoff"), &MaxBackoff);
+                Add(_T("retries"), &Retries);
+                Add(_T("window"), &Window);
+            }
+            ~Supervisor() {
+            }
+
+        public:
+            Core::JSON::EnumType<supervision> Policy;
+            Core::JSON::DecUInt32 Backoff; // ms
+            Core::JSON::DecUInt32 MaxBackoff; // ms
+            Core::JSON::DecUInt8 Retries;
+            Core::JSON::DecUInt16 Window; // s
+        };
+
+    public:
+        class Entry : public Core::JSON::Container {
+        private:
+            Entry& operator=(const Entry&) = delete;
+
+        public:
+            Entry()
+                : Core::JSON::Container()
+                , Command()
+                , Parameters()
+                , ScheduleTime()
+                , Priority(0)
+                , Overlap(DISCARD)
+                , Concurrency(1)
+                , Restart()
+                , Capture()
+                , Limits()
+                , Critical(false) {
+                Add(_T("command"), &Command);
+                Add(_T("parameters"), &Parameters);
+                Add(_T("schedule"), &ScheduleTime);
+                Add(_T("priority"), &Priority);
+                Add(_T("overlap"), &Overlap);
+                Add(_T("concurrency"), &Concurrency);
+                Add(_T("restart"), &Restart);
+                Add(_T("output"), &Capture);
+                Add(_T("resources"), &Limits);
+                Add(_T("critical"), &Critical);
+            }
+            Entry(const Entry& copy)
+                : Core::JSON::Container()
+                , Command(copy.Command)
+                , Parameters(copy.Parameters)
+                , ScheduleTime(copy.ScheduleTime)
+                , Priority(copy.Priority)
+                , Overlap(copy.Overlap)
+                , Concurrency(copy.Concurrency)
+                , Restart(copy.Restart)
+                , Capture(copy.Capture)
+                , Limits(copy.Limits)
+                , Critical(copy.Critical) {
+                Add(_T("command"), &Command);
+                Add(_T("parameters"), &Parameters);
+                Add(_T("schedule"), &ScheduleTime);
+                Add(_T("priority"), &Priority);
+                Add(_T("overlap"), &Overlap);
+                Add(_T("concurrency"), &Concurrency);
+                Add(_T("restart"), &Restart);
+                Add(_T("output"), &Capture);
+                Add(_T("resources"), &Limits);
+                Add(_T("critical"), &Critical);
+            }
+            ~Entry() {
+            }
+
+        public:
+            Core::JSON::String Command;
+            Core::JSON::ArrayType<Parameter> Parameters;
+            Schedule ScheduleTime;
+            Core::JSON::DecUInt8 Priority;
+            Core::JSON::EnumType<overlap> Overlap;
+            Core::JSON::DecUInt8 Concurrency;
+            Supervisor Restart;
+            Output Capture;
+            Resources Limits;
+            // Launched whatever the pressure.
+            Core::JSON::Boolean Critical;
+        };
+
+    public:
+        Config()
+            : Core::JSON::Container()
+            , Command()
+            , CloseTime(3)
+            , Observer(NETLINK)
+            , CGroup()
+            , MemoryUsage()
+            , Zygote(false)
+            , Commands()
+            , Parallelism(0)
+            , Queue(FIFO)
+            , Stop()
+            , Gate()
+        {
+            Add(_T("command"), &Command);
+            Add(_T("closetime"), &CloseTime);
+            Add(_T("observer"), &Observer);
+            Add(_T("cgroup"), &CGroup);
+            Add(_T("memory"), &MemoryUsage);
+            Add(_T("zygote"), &Zygote);
+            Add(_T("commands"), &Commands);
+            Add(_T("parallelism"), &Parallelism);
+            Add(_T("queue"), &Queue);
+            Add(_T("stop"), &Stop);
+            Add(_T("pressure"), &Gate);
+        }
+        ~Config()
+        {
+        }
+
+    public:
+        // If set, the configuration itself is the only Entry.
+        Core::JSON::String Command;
+        Core::JSON::DecUInt8 CloseTime;
+        Core::JSON::EnumType<backend> Observer;
+        Core::JSON::String CGroup;
+        Memory MemoryUsage;
+        Core::JSON::Boolean Zygote;
+        Core::JSON::ArrayType<Entry> Commands;
+        Core::JSON::DecUInt8 Parallelism;
+        Core::JSON::EnumType<order> Queue;
+        Core::JSON::ArrayType<Step> Stop;
+        Pressure Gate;
+    };
+
+public:
+    class Statistics : public Core::JSON::Container {
+    private:
+        Statistics(const Statistics&) = delete;
+        Statistics& operator=(const Statistics&) = delete;
+
+    public:
+        class Duration : public Core::JSON::Container {
+        private:
+            Duration& operator=(const Duration&) = delete;
+
+        public:
+            Duration()
+                : Core::JSON::Container()
+                , Last(0)
+                , Max(0)
+                , Average(0) {
+                Add(_T("last"), &Last);
+                Add(_T("max"), &Max);
+                Add(_T("average"), &Average);
+            }
+            Duration(const Duration& copy)
+                : Core::JSON::Container()
+                , Last(copy.Last)
+                , Max(copy.Max)
+                , Average(copy.Average) {
+                Add(_T("last"), &Last);
+                Add(_T("max"), &Max);
+                Add(_T("average"), &Average);
+            }
+            ~Duration() {
+            }
+
+        public:
+            Core::JSON::DecUInt64 Last; // ms
+            Core::JSON::DecUInt64 Max; // ms
+            Core::JSON::DecUInt64 Average; // ms
+        };
+
+    public:
+        class Resources : public Core::JSON::Container {
+        private:
+            Resources& operator=(const Resources&) = delete;
+
+        public:
+            Resources()
+                : Core::JSON::Container()
+                , User(0)
+                , System(0)
+                , MaxResident(0)
+                , Read(0)
+                , Written(0)
+                , Voluntary(0)
+                , Involuntary(0) {
+                Add(_T("user"), &User);
+                Add(_T("system"), &System);
+                Add(_T("maxresident"), &MaxResident);
+                Add(_T("read"), &Read);
+                Add(_T("written"), &Written);
+                Add(_T("voluntary"), &Voluntary);
+                Add(_T("involuntary"), &Involuntary);
+            }
+            Resources(const Resources& copy)
+                : Core::JSON::Container()
+                , User(copy.User)
+                , System(copy.System)
+                , MaxResident(copy.MaxResident)
+                , Read(copy.Read)
+                , Written(copy.Written)
+                , Voluntary(copy.Voluntary)
+                , Involuntary(copy.Involuntary) {
+                Add(_T("user"), &User);
+                Add(_T("system"), &System);
+                Add(_T("maxresident"), &MaxResident);
+                Add(_T("read"), &Read);
+                Add(_T("written"), &Written);
+                Add(_T("voluntary"), &Voluntary);
+                Add(_T("involuntary"), &Involuntary);
+            }
+            ~Resources() {
+            }
+
+        public:
+            void Set(const Usage& usage) {
+                User = usage.User / 1000;
+                System = usage.System / 1000;
+                MaxResident = usage.MaxResident;
+                Read = usage.Read;
+                Written = usage.Written;
+                Voluntary = usage.Voluntary;
+                Involuntary = usage.Involuntary;
+            }
+
+        public:
+            Core::JSON::DecUInt64 User; // ms
+            Core::JSON::DecUInt64 System; // ms
+            Core::JSON::DecUInt64 MaxResident; // KiB
+            Core::JSON::DecUInt64 Read; // bytes
+            Core::JSON::DecUInt64 Written; // bytes
+            Core::JSON::DecUInt64 Voluntary;
+            Core::JSON::DecUInt64 Involuntary;
+        };
+
+    public:
+        class Run : public Core::JSON::Container {
+        private:
+            Run& operator=(const Run&) = delete;
+
+        public:
+            Run()
+                : Core::JSON::Container()
+                , Start()
+                , Latency(0)
+                , Duration(0)
+                , ExitCode(0)
+                , Processes(0)
+                , Stop(0)
+                , Killed(false)
+                , Usage() {
+                Add(_T("start"), &Start);
+                Add(_T("latency"), &Latency);
+                Add(_T("duration"), &Duration);
+                Add(_T("exitcode"), &ExitCode);
+                Add(_T("processes"), &Processes);
+                Add(_T("stop"), &Stop);
+                Add(_T("killed"), &Killed);
+                Add(_T("usage"), &Usage);
+            }
+            Run(const Run& copy)
+                : Core::JSON::Container()
+                , Start(copy.Start)
+                , Latency(copy.Latency)
+                , Duration(copy.Duration)
+                , ExitCode(copy.ExitCode)
+                , Processes(copy.Processes)
+                , Stop(copy.Stop)
+                , Killed(copy.Killed)
+                , Usage(copy.Usage) {
+                Add(_T("start"), &Start);
+                Add(_T("latency"), &Latency);
+                Add(_T("duration"), &Duration);
+                Add(_T("exitcode"), &ExitCode);
+                Add(_T("processes"), &Processes);
+                Add(_T("stop"), &Stop);
+                Add(_T("killed"), &Killed);
+                Add(_T("usage"), &Usage);
+            }
+            ~Run() {
+            }
+
+        public:
+            Core::JSON::String Start;
+            Core::JSON::DecUInt32 Latency; // ms
+            Core::JSON::DecUInt32 Duration; // ms
+            Core::JSON::DecUInt32 ExitCode;
+            Core::JSON::DecUInt32 Processes;
+            Core::JSON::DecUInt8 Stop;
+            Core::JSON::Boolean Killed;
+            Resources Usage;
+        };
+
+    public:
+        class Activity : public Core::JSON::Container {
+        private:
+            Activity& operator=(const Activity&) = delete;
+
+        public:
+            Activity()
+                : Core::JSON::Container()
+                , Command()
+                , Runs(0)
+                , Active(0)
+                , Skipped(0)
+                , Restarted(0)
+                , Respawns(0)
+                , Deferred(0)
+                , Duration()
+                , Usage()
+                , History() {
+                Add(_T("command"), &Command);
+                Add(_T("runs"), &Runs);
+                Add(_T("active"), &Active);
+                Add(_T("skipped"), &Skipped);
+                Add(_T("restarted"), &Restarted);
+                Add(_T("respawns"), &Respawns);
+                Add(_T("deferred"), &Deferred);
+                Add(_T("duration"), &Duration);
+                Add(_T("usage"), &Usage);
+                Add(_T("history"), &History);
+            }
+            Activity(const Activity& copy)
+                : Core::JSON::Container()
+                , Command(copy.Command)
+                , Runs(copy.Runs)
+                , Active(copy.Active)
+                , Skipped(copy.Skipped)
+                , Restarted(copy.Restarted)
+                , Respawns(copy.Respawns)
+                , Deferred(copy.Deferred)
+                , Duration(copy.Duration)
+                , Usage(copy.Usage)
+                , History(copy.History) {
+                Add(_T("command"), &Command);
+                Add(_T("runs"), &Runs);
+                Add(_T("active"), &Active);
+                Add(_T("skipped"), &Skipped);
+                Add(_T("restarted"), &Restarted);
+                Add(_T("respawns"), &Respawns);
+                Add(_T("deferred"), &Deferred);
+                Add(_T("duration"), &Duration);
+                Add(_T("usage"), &Usage);
+                Add(_T("history"), &History);
+            }
+            ~Activity() {
+            }
+
+        public:
+            Core::JSON::String Command;
+            Core::JSON::DecUInt32 Runs;
+            Core::JSON::DecUInt32 Active;
+            Core::JSON::DecUInt32 Skipped;
+            Core::JSON::DecUInt32 Restarted;
+            Core::JSON::DecUInt32 Respawns;
+            // Runs that waited for the pressure to drop.
+            Core::JSON::DecUInt32 Deferred;
+            Statistics::Duration Duration;
+            // Of all runs together.
+            Resources Usage;
+            // The last runs, the oldest first.
+            Core::JSON::ArrayType<Run> History;
+        };
+
+    public:
+        Statistics()
+            : Core::JSON::Container()
+            , LostEvents(0)
+            , Activities()
+        {
+            Add(_T("lostevents"), &LostEvents);
+            Add(_T("activities"), &Activities);
+        }
+        ~Statistics()
+        {
+        }
+
+    public:
+        Core::JSON::DecUInt32 LostEvents;
+        Core::JSON::ArrayType<Activity> Activities;
+    };
+
+public:
+    // The last output of one of the commands.
+    class OutputData : public Core::JSON::Container {
+    private:
+        OutputData(const OutputData&) = delete;
+        OutputData& operator=(const OutputData&) = delete;
+
+    public:
+        OutputData()
+            : Core::JSON::Container()
+            , Index(0)
+            , Command()
+            , Output()
+        {
+            Add(_T("index"), &Index);
+            Add(_T("command"), &Command);
+            Add(_T("output"), &Output);
+        }
+        ~OutputData()
+        {
+        }
+
+    public:
+        Core::JSON::DecUInt8 Index;
+        Core::JSON::String Command;
+        Core::JSON::String Output;
+    };
+
+    private:
+    class Time {
+    public:
+        Time()
+        : _hour(~0)
+        , _minute(~0)
+        , _second(~0) {
+        }
+        Time(const string& time) 
+        : _hour(~0) 
+        , _minute(~0)
+        , _second(~0) {
+            Parse(time);
+        }
+        Time(const Time& copy) 
+        : _hour(copy._hour) 
+        , _minute(copy._minute)
+        , _second(copy._second) {
+        }
+        ~Time () = default;
+
+        Time& operator= (const Time& rhs) {
+            _hour = rhs._hour; 
+            _minute = rhs._minute;
+            _second = rhs._second;
+
+            return (*this);
+        }
+
+        static constexpr uint32_t MilliSecondsPerSecond = 1000;
+        static constexpr uint32_t SecondsPerMinute = 60;
+        static constexpr uint32_t MinutesPerHour = 60;
+        static constexpr uint32_t HoursPerDay = 24;
+
+    public:
+        bool IsValid () const { return (HasSeconds() || HasMinutes() || HasHours()); }
+        bool HasHours() const { return (_hour < HoursPerDay); }
+        bool HasMinutes() const { return (_minute < MinutesPerHour); }
+        bool HasSeconds() const { return (_second < SecondsPerMinute); }
+        uint8_t Hours() const { return _hour; }
+        uint8_t Minutes() const { return _minute; }
+        uint8_t Seconds() const { return _second; }
+        uint32_t TimeInSeconds() const {
+            return ( (HasHours() ? Hours() : 0) * MinutesPerHour * SecondsPerMinute + 
+                     (HasMinutes() ? Minutes() : 0) * SecondsPerMinute + 
+                      Seconds() );
+        }
+
+    private:
+        void Parse(const string& time) {
+            bool status = true;
+            string t = time;
+
+            //Get hours
+            uint8_t hour = (~0);
+            string hValue = Split(t, ":");
+            if (hValue.empty() != true) {
+                status = IsValidTime(hValue, hour, HoursPerDay);
+            }
+            if (status == true) {
+                //Get minutes
+                uint8_t minute = (~0);
+                string mValue = Split(t, ".");
+                if (mValue.empty() != true) {
+                    status = IsValidTime(mValue, minute, MinutesPerHour);
+                }
+                if (status == true) {
+
+                    //Store seconds
+                    uint8_t second = (~0);
+                    string sValue = t;
+                    if (sValue.empty() != true) {
+                        status = IsValidTime(sValue, second, SecondsPerMinute);
+                    }
+                    if (status  == true) {
+
+                        //Check all the time components are still valid
+                        if ((hour != static_cast<uint8_t>(~0) && second != static_cast<uint8_t>(~0)) && (minute == static_cast<uint8_t>(~0))) {
+                            TRACE(Trace::Information, (_T("Invalid time format: the given format is HH:MM.SS")));
+                        }
+                        else { //Update time components
+                            _hour = hour;
+                            _minute = minute;
+                            _second = second;
+                        }
+                    }
+                }
+            }
+        }
+
+    private:
+        inline bool IsDigit(const string& str) {
+            return (str.find_first_not_of( "0123456789" ) == std::string::npos);
+        }
+
+        inline bool IsValidTime(const string& str, uint8_t& time, const uint8_t limit) {
+            bool status = true;
+            if (IsDigit(str)) {
+                int t = atoi(str.c_str());
+                if (t >= limit || t < 0) {
+                    status = false;
+                    TRACE(Trace::Information, (_T("Invalid time  %s"), str.c_str()));
+                }
+                else {
+                    time = t;
+                }
+            }
+            else {
+                status = false;
+                TRACE(Trace::Information, (_T("Invalid time %s"), str.c_str()));
+            }
+            return status;
+        }
+
+        inline string Split(string& str, const string delimiter) {
+            string word;
+            size_t position = str.find(delimiter, 0);
+            if (position != string::npos) {
+                word = str.substr(0, position);
+                str = str.substr(word.size() + 1, str.size());
+            }
+            return word;
+        }
+
+    private:
+        uint8_t _hour;
+        uint8_t _minute;
+        uint8_t _second;
+    };
+
+    // A cron expression, the arithmetic lives with the rest of it, in Timing.h.
+    typedef Timing::Cron Cron;
+
+    // Snapshot of the process hierarchy, as the kernel reports it through /proc.
+    class ProcessTree {
+    public:
+        typedef std::unordered_map<uint32_t, uint32_t> Parents;
+        typedef std::unordered_multimap<uint32_t, uint32_t> ChildMap;
+
+    public:
+        ProcessTree() = delete;
+        ProcessTree(const ProcessTree&) = delete;
+        ProcessTree& operator=(const ProcessTree&) = delete;
+
+    public:
+        // Collect the parent of every running process (thread group), zombies excluded.
+        static void Snapshot(Parents& parents) {
+            DIR* directory = ::opendir("/proc");
+
+            parents.clear();
+
+            if (directory != nullptr) {
+                struct dirent* entry;
+
+                while ((entry = ::readdir(directory)) != nullptr) {
+                    uint32_t parent;
+                    char* end;
+                    uint32_t pid = static_cast<uint32_t>(::strtoul(entry->d_name, &end, 10));
+
+                    if ((*end == '\0') && (pid != 0) && (Parent(pid, parent) == true)) {
+                        parents[pid] = parent;
+                    }
+                }
+                ::closedir(directory);
+            }
+        }
+        // Add all descendants of the given processes to the list, they are looked up in the snapshot.
+        template <typename LIST>
+        static void Descendants(const Parents& parents, LIST& list) {
+            ChildMap children;
+            std::vector<uint32_t> pending(list.begin(), list.end());
+
+            for (const std::pair<const uint32_t, uint32_t>& entry : parents) {
+                children.emplace(entry.second, entry.first);
+            }
+
+            while (pending.empty() == false) {
+                const uint32_t pid = pending.back();
+                pending.pop_back();
+
+                auto range = children.equal_range(pid);
+                for (auto index = range.first; index != range.second; index++) {
+                    if (list.insert(index->second).second == true) {
+                        pending.push_back(index->second);
+                    }
+                }
+            }
+        }
+        // Order the processes so children come before their parents, the deepest first.
+        static void ChildrenFirst(const Parents& parents, std::vector<uint32_t>& list) {
+            std::vector<std::pair<uint32_t, uint32_t>> depths;
+
+            for (const uint32_t pid : list) {
+                uint32_t depth = 0;
+                Parents::const_iterator index(parents.find(pid));
+
+                while ((index != parents.end()) && (depth < parents.size())) {
+                    depth++;
+                    index = parents.find(index->second);
+                }
+                depths.emplace_back(depth, pid);
+            }
+
+            std::sort(depths.begin(), depths.end(), std::greater<std::pair<uint32_t, uint32_t>>());
+
+            for (uint32_t index = 0; index < depths.size(); index++) {
+                list[index] = depths[index].second;
+            }
+        }
+        // The children of all threads of a process. Returns false if the kernel does not offer these lists.
+        static bool Children(const uint32_t pid, std::vector<uint32_t>& children) {
+            bool result = false;
+            char path[64];
+
+            ::snprintf(path, sizeof(path), "/proc/%u/task", pid);
+
+            DIR* directory = ::opendir(path);
+
+            if (directory != nullptr) {
+                struct dirent* entry;
+
+                while ((entry = ::readdir(directory)) != nullptr) {
+                    if (entry->d_name[0] != '.') {
+                        ::snprintf(path, sizeof(path), "/proc/%u/task/%s/children", pid, entry->d_name);
+
+                        int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+
+                        if (fd >= 0) {
+                            char buffer[256];
+                            ssize_t length;
+                            uint32_t value = 0;
+                            bool digits = false;
+
+                            result = true;
+
+                            while ((length = ::read(fd, buffer, sizeof(buffer))) > 0) {
+                                for (ssize_t index = 0; index < length; index++) {
+                                    if ((buffer[index] >= '0') && (buffer[index] <= '9')) {
+                                        value = (value * 10) + (buffer[index] - '0');
+                                        digits = true;
+                                    }
+                                    else if (digits == true) {
+                                        children.push_back(value);
+                                        value = 0;
+                                        digits = false;
+                                    }
+                                }
+                            }
+                            if (digits == true) {
+                                children.push_back(value);
+                            }
+                            ::close(fd);
+                        }
+                    }
+                }
+                ::closedir(directory);
+            }
+
+            return (result);
+        }
+        static bool Parent(const uint32_t pid, uint32_t& parent) {
+            bool result = false;
+            char buffer[512];
+            char path[32];
+
+            ::snprintf(path, sizeof(path), "/proc/%u/stat", pid);
+
+            int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+
+            if (fd >= 0) {
+                ssize_t length = ::read(fd, buffer, sizeof(buffer) - 1);
+
+                if (length > 0) {
+                    buffer[length] = '\0';
+
+                    // The name of the command is between braces and can hold anything, so skip till the last one.
+                    const char* data = ::strrchr(buffer, ')');
+                    char state;
+                    unsigned int ppid;
+
+                    if ((data != nullptr) && (::sscanf(data + 1, " %c %u", &state, &ppid) == 2) && (state != 'Z') && (state != 'X')) {
+                        parent = ppid;
+                        result = true;
+                    }
+                }
+                ::close(fd);
+            }
+
+            return (result);
+        }
+    };
+
+public:
+    // Collects what the launched processes write to their stdout and stderr, in a ring buffer of a
+    // fixed size and/or in a file that is rotated once it is big enough. Without a buffer, the pipe is
+    // spliced into the file, so the output is not even copied through here.
+    class Capture : public Core::IResource {
+    private:
+        static constexpr uint32_t Chunk = 65536;
+
+    public:
+        Capture() = delete;
+        Capture(const Capture&) = delete;
+        Capture& operator=(const Capture&) = delete;
+
+        Capture(const uint32_t size, const string& file, const uint32_t limit, const uint8_t files)
+            : _adminLock()
+            , _buffer(size)
+            , _head(0)
+            , _length(0)
+            , _file(file)
+            , _limit(limit)
+            , _files(files)
+            , _splice(true)
+            , _fd(-1)
+            , _written(0)
+        {
+            _pipe[0] = -1;
+            _pipe[1] = -1;
+        }
+        ~Capture() override
+        {
+            Close();
+        }
+
+    public:
+        bool IsValid() const {
+            return ((_buffer.empty() == false) || (_file.empty() == false));
+        }
+        // The end the processes write to.
+        int Sink() const {
+            return (_pipe[1]);
+        }
+        uint32_t Open() {
+            uint32_t result = Core::ERROR_NONE;
+
+            if (IsValid() == true) {
+                if (::pipe2(_pipe, O_CLOEXEC) != 0) {
+                    result = Core::ERROR_OPENING_FAILED;
+                }
+                else if ((_file.empty() == false) && (Reopen() == false)) {
+                    TRACE(Trace::Error, (_T("Could not open output file %s, error: %d."), _file.c_str(), errno));
+                    ::close(_pipe[0]);
+                    ::close(_pipe[1]);
+                    _pipe[0] = -1;
+                    _pipe[1] = -1;
+                    result = Core::ERROR_OPENING_FAILED;
+                }
+                else {
+                    ::fcntl(_pipe[0], F_SETFL, O_NONBLOCK);
+                    Core::ResourceMonitor::Instance().Register(*this);
+                }
+            }
+
+            return (result);
+        }
+        void Close() {
+            if (_pipe[0] != -1) {
+                Core::ResourceMonitor::Instance().Unregister(*this);
+
+                // Whatever was written last.
+                Drain();
+
+                ::close(_pipe[0]);
+                ::close(_pipe[1]);
+                _pipe[0] = -1;
+                _pipe[1] = -1;
+            }
+            if (_fd != -1) {
+                ::close(_fd);
+                _fd = -1;
+            }
+        }
+        // The last output, at most length bytes of it.
+        void Tail(string& output, const uint32_t length) {
+            output.clear();
+
+            Drain();
+
+            _adminLock.Lock();
+
+            if (_buffer.empty() == false) {
+                const uint32_t size = static_cast<uint32_t>(_buffer.size());
+                const uint32_t available = static_cast<uint32_t>(std::min(std::min(_length, static_cast<uint64_t>(size)), static_cast<uint64_t>(length)));
+                const uint32_t start = (_head + size - available) % size;
+
+                if ((start + available) <= size) {
+                    output.assign(&(_buffer[start]), available);
+                }
+                else {
+                    output.assign(&(_buffer[start]), size - start);
+                    output.append(&(_buffer[0]), available - (size - start));
+                }
+            }
+            else if (_fd != -1) {
+                const uint64_t available = std::min(_written, static_cast<uint64_t>(length));
+
+                if ((available < length) && (_files > 0)) {
+                    // Just rotated, the rest is in the previous one.
+                    const int previous = ::open((_file + _T(".1")).c_str(), O_RDONLY | O_CLOEXEC);
+
+                    if (previous != -1) {
+                        Load(previous, ::lseek(previous, 0, SEEK_END), static_cast<uint32_t>(length - available), output);
+                        ::close(previous);
+                    }
+                }
+
+                Load(_fd, static_cast<off_t>(_written), static_cast<uint32_t>(available), output);
+            }
+
+            _adminLock.Unlock();
+        }
+
+    private:
+        // Appends the last length bytes before end of the file.
+        static void Load(const int fd, const off_t end, const uint32_t length, string& output) {
+            const size_t offset = output.length();
+            const uint32_t available = (end > 0 ? static_cast<uint32_t>(std::min(static_cast<uint64_t>(end), static_cast<uint64_t>(length))) : 0);
+
+            output.resize(offset + available);
+
+            const ssize_t loaded = (available == 0 ? 0 : ::pread(fd, &(output[offset]), available, end - available));
+            output.resize(offset + (loaded > 0 ? static_cast<size_t>(loaded) : 0));
+        }
+        handle Descriptor() const override {
+            return (_pipe[0]);
+        }
+        uint16_t Events() override {
+            return (POLLIN);
+        }
+        void Handle(const uint16_t /* events */) override {
+            Drain();
+        }
+        void Drain() {
+            ssize_t length = 1;
+
+            _adminLock.Lock();
+
+            while (length > 0) {
+                if ((_buffer.empty() == true) && (_splice == true) && (_fd != -1)) {
+                    length = ::splice(_pipe[0], nullptr, _fd, nullptr, Chunk, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+
+                    if ((length < 0) && (errno == EINVAL)) {
+                        // The file system of the file does not support it, copy it from here on.
+                        _splice = false;
+                        length = 1;
+                        continue;
+                    }
+                }
+                else {
+                    char scratch[512];
+                    char* target = (_buffer.empty() == true ? scratch : &(_buffer[_head]));
+                    const size_t room = (_buffer.empty() == true ? sizeof(scratch) : _buffer.size() - _head);
+
+                    length = ::read(_pipe[0], target, room);
+
+                    if (length > 0) {
+                        if (_buffer.empty() == false) {
+                            _head = static_cast<uint32_t>((_head + length) % _buffer.size());
+                            _length += length;
+                        }
+                        if ((_fd != -1) && (::write(_fd, target, length) != length)) {
+                            TRACE(Trace::Error, (_T("Could not write all output to %s, error: %d."), _file.c_str(), errno));
+                        }
+                    }
+                }
+
+                if ((length > 0) && (_fd != -1)) {
+                    _written += length;
+
+                    if ((_limit != 0) && (_written >= _limit)) {
+                        Rotate();
+                    }
+                }
+            }
+
+            _adminLock.Unlock();
+        }
+        // Called with the lock taken, the file becomes <file>.1, the oldest one is dropped.
+        void Rotate() {
+            ::close(_fd);
+            _fd = -1;
+
+            if (_files == 0) {
+                ::unlink(_file.c_str());
+            }
+            else {
+                for (uint8_t index = _files - 1; index > 0; index--) {
+                    ::rename((_file + '.' + Core::NumberType<uint8_t>(index).Text()).c_str(), (_file + '.' + Core::NumberType<uint8_t>(index + 1).Text()).c_str());
+                }
+                ::rename(_file.c_str(), (_file + _T(".1")).c_str());
+            }
+
+            if (Reopen() == false) {
+                TRACE(Trace::Error, (_T("Could not reopen output file %s, error: %d."), _file.c_str(), errno));
+            }
+        }
+        // Not opened for appending, splicing into such a file is not allowed. Readable, Tail reads it back.
+        bool Reopen() {
+            _fd = ::open(_file.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+
+            if (_fd != -1) {
+                const off_t end = ::lseek(_fd, 0, SEEK_END);
+                _written = (end > 0 ? static_cast<uint64_t>(end) : 0);
+            }
+
+            return (_fd != -1);
+        }
+
+    private:
+        Core::CriticalSection _adminLock;
+        std::vector<char> _buffer;
+        uint32_t _head;
+        uint64_t _length;
+        const string _file;
+        const uint32_t _limit;
+        const uint8_t _files;
+        bool _splice;
+        int _fd;
+        uint64_t _written;
+        int _pipe[2];
+    };
+
+private:
+    // Launches a command with Spawn, without copying the address space of the host, in the control
+    // group if one is given. Alternatively the launch can be delegated to a zygote, which then reports
+    // the exit.
+    class Zygote;
+
+    class ChildProcess {
+    public:
+        ChildProcess() = delete;
+        ChildProcess(const ChildProcess&) = delete;
+        ChildProcess& operator=(const ChildProcess&) = delete;
+
+        explicit ChildProcess(const string& command)
+            : _arguments({ command })
+            , _pid(0)
+            , _exitCode(0)
+            , _usage()
+            , _inherit(-1)
+            , _output(-1)
+            , _scheduling()
+            , _zygote(nullptr)
+        {
+        }
+        ~ChildProcess() = default;
+
+        // The exit code of a command that could not be executed, as a shell would report it.
+        static constexpr uint32_t NotExecuted = 127;
+
+    public:
+        const string& Command() const {
+            return (_arguments.front());
+        }
+        void Add(const string& argument) {
+            _arguments.push_back(argument);
+        }
+        const std::vector<string>& Arguments() const {
+            return (_arguments);
+        }
+        uint32_t ExitCode() const {
+            return (_exitCode);
+        }
+        // What it, and the descendants it waited for, used. Known once it is reaped.
+        const Usage& Resources() const {
+            return (_usage);
+        }
+        // This descriptor is passed on to the command.
+        void Inherit(const int descriptor) {
+            _inherit = descriptor;
+        }
+        // Its stdout and stderr are written to this descriptor.
+        void Redirect(const int descriptor) {
+            _output = descriptor;
+        }
+        int Output() const {
+            return (_output);
+        }
+        void Constrain(const Scheduling& scheduling) {
+            _scheduling = scheduling;
+        }
+        const Scheduling& Constraints() const {
+            return (_scheduling);
+        }
+        void Delegate(Zygote* zygote) {
+            _zygote = zygote;
+        }
+        static uint32_t ExitCode(const int status) {
+            return (WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status));
+        }
+        // If the command could not be executed, the child is gone already, but its pid is still returned.
+        uint32_t Launch(const ControlGroup* group, uint32_t* pid) {
+            uint32_t result = Core::ERROR_NONE;
+
+            if (_zygote != nullptr) {
+                result = _zygote->Launch(group, _arguments, _scheduling, _output, *pid);
+
+                _exitCode = (result == Core::ERROR_NONE ? 0 : NotExecuted);
+                _pid = (result == Core::ERROR_NONE ? *pid : 0);
+
+                return (result);
+            }
+
+            std::vector<char*> arguments;
+            int error = 0;
+
+            // The child can not allocate anything, so prepare all it needs.
+            for (string& argument : _arguments) {
+                arguments.push_back(&(argument[0]));
+            }
+            arguments.push_back(nullptr);
+
+            const int procs = (group != nullptr ? group->Procs() : -1);
+            const pid_t child = Spawn(arguments.data(), procs, _inherit, _output, _scheduling, error);
+
+            if (procs != -1) {
+                ::close(procs);
+            }
+
+            if (child == -1) {
+                TRACE(Trace::Error, (_T("Could not launch %s, error: %d."), Command().c_str(), error));
+                _exitCode = NotExecuted;
+                _pid = 0;
+                result = Core::ERROR_UNAVAILABLE;
+            }
+            else if (error != 0) {
+                TRACE(Trace::Error, (_T("Could not execute %s, error: %d."), Command().c_str(), error));
+                _exitCode = NotExecuted;
+                _pid = 0;
+                result = Core::ERROR_UNAVAILABLE;
+            }
+            else {
+                _exitCode = 0;
+                _pid = child;
+            }
+
+            *pid = static_cast<uint32_t>(child == -1 ? 0 : child);
+
+            return (result);
+        }
+        bool IsActive() {
+            if (_zygote != nullptr) {
+                struct rusage usage;
+                int status;
+
+                // Once the zygote is gone, what it did not report before it left, is lost.
+                const bool operational = ((_pid != 0) && (_zygote->IsOperational() == true));
+
+                if ((_pid != 0) && (_zygote->Exited(_pid, status, usage, 0) == true)) {
+                    _exitCode = ExitCode(status);
+                    _usage.Add(usage);
+                    _pid = 0;
+                }
+                else if ((_pid != 0) && (operational == false)) {
+                    TRACE(Trace::Error, (_T("The zygote is gone, the exit of %s [%d] is lost."), Command().c_str(), _pid));
+                    _pid = 0;
+                }
+            }
+            else if (_pid != 0) {
+                struct rusage usage;
+                int status;
+                pid_t result = ::wait4(_pid, &status, WNOHANG, &usage);
+
+                if (result == _pid) {
+                    _exitCode = ExitCode(status);
+                    _usage.Add(usage);
+                    _pid = 0;
+                }
+                else if ((result == -1) && (errno == ECHILD)) {
+                    // Somebody else reaped it, the exit code is lost.
+                    _pid = 0;
+                }
+            }
+            return (_pid != 0);
+        }
+        void Kill(const bool hardKill) {
+            if (_pid != 0) {
+                ::kill(_pid, hardKill ? SIGKILL : SIGTERM);
+            }
+        }
+        // Blocks, so not to be used on the threads delivering the events, IsActive reaps without waiting.
+        uint32_t WaitProcessCompleted(const uint32_t waitTime) {
+            struct rusage usage;
+            int status;
+
+            if ((_zygote != nullptr) && (_pid != 0) && (_zygote->Exited(_pid, status, usage, waitTime) == true)) {
+                _exitCode = ExitCode(status);
+                _usage.Add(usage);
+                _pid = 0;
+            }
+
+            uint32_t left = (_zygote != nullptr ? 0 : waitTime);
+
+            while ((IsActive() == true) && (left > 0)) {
+                const uint32_t slice = (left > PollTime ? PollTime : left);
+                SleepMs(slice);
+                left -= slice;
+            }
+
+            return (IsActive() == true ? Core::ERROR_TIMEDOUT : Core::ERROR_NONE);
+        }
+
+    private:
+        static constexpr uint32_t PollTime = 10; // ms
+
+        std::vector<string> _arguments;
+        pid_t _pid;
+        uint32_t _exitCode;
+        Usage _usage;
+        int _inherit;
+        int _output;
+        Scheduling _scheduling;
+        Zygote* _zygote;
+    };
+
+    // A small helper process, started once, that launches the commands for us. Forking it is far
+    // cheaper than forking the host. As the commands are its children, it reports their exit.
+    class Zygote {
+    private:
+        struct Exit {
+            int Status;
+            struct rusage Usage;
+        };
+
+        typedef std::unordered_map<uint32_t, Exit> Exits;
+
+        static constexpr uint32_t LaunchTime = 2000; // ms
+        static constexpr uint32_t CloseTime = 1000; // ms
+        static constexpr uint32_t PollTime = 10; // ms
+
+    public:
+        Zygote() = delete;
+        Zygote(const Zygote&) = delete;
+        Zygote& operator=(const Zygote&) = delete;
+
+        explicit Zygote(const string& helper)
+            : _adminLock()
+            , _helper(helper)
+            , _socket(-1)
+            , _exits()
+        {
+        }
+        ~Zygote()
+        {
+            Close();
+        }
+
+    public:
+        uint32_t Open() {
+            uint32_t result = Core::ERROR_UNAVAILABLE;
+            int sockets[2];
+
+            if (::socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sockets) == 0) {
+                uint32_t pid;
+
+                _helper.Add(Core::NumberType<int>(sockets[1]).Text());
+                _helper.Inherit(sockets[1]);
+
+                result = _helper.Launch(nullptr, &pid);
+
+                ::close(sockets[1]);
+
+                if (result == Core::ERROR_NONE) {
+                    _socket = sockets[0];
+                }
+                else {
+                    ::close(sockets[0]);
+                }
+            }
+
+            return (result);
+        }
+        void Close() {
+            if (_socket != -1) {
+                // Seeing the connection close, the helper leaves.
+                ::close(_socket);
+                _socket = -1;
+
+                if (_helper.WaitProcessCompleted(CloseTime) != Core::ERROR_NONE) {
+                    _helper.Kill(true);
+                    _helper.WaitProcessCompleted(CloseTime);
+                }
+            }
+        }
+        // The output descriptor, if any, is passed along with the request.
+        uint32_t Launch(const ControlGroup* group, const std::vector<string>& arguments, const Scheduling& scheduling, const int output, uint32_t& pid) {
+            uint32_t result = Core::ERROR_UNAVAILABLE;
+            ZygoteMessage header;
+            string message;
+
+            ::memset(&header, 0, sizeof(header));
+            header.Command = ZygoteMessage::LAUNCH;
+
+            message.append(reinterpret_cast<const char*>(&header), sizeof(header));
+            message.append(reinterpret_cast<const char*>(&scheduling), sizeof(scheduling));
+            message.append(group != nullptr ? group->Path() : string());
+            message.push_back('\0');
+            for (const string& argument : arguments) {
+                message.append(argument);
+                message.push_back('\0');
+            }
+
+            pid = 0;
+
+            _adminLock.Lock();
+
+            if (message.length() > ZygoteMessage::MaxLength) {
+                TRACE(Trace::Error, (_T("Command line of %s is too long for the zygote."), arguments.front().c_str()));
+            }
+            else if (Send(message, output) == true) {
+                ZygoteMessage reply;
+                reply.Command = 0;
+
+                while ((reply.Command != ZygoteMessage::STARTED) && (Receive(reply, LaunchTime) == true)) {
+                }
+
+                if (reply.Command != ZygoteMessage::STARTED) {
+                    TRACE(Trace::Error, (_T("Zygote did not respond to launch %s."), arguments.front().c_str()));
+                }
+                else if (reply.Value != 0) {
+                    TRACE(Trace::Error, (_T("Could not execute %s, error: %d."), arguments.front().c_str(), reply.Value));
+                    pid = reply.Pid;
+                }
+                else {
+                    pid = reply.Pid;
+                    result = Core::ERROR_NONE;
+                }
+            }
+
+            _adminLock.Unlock();
+
+            return (result);
+        }
+        // If the helper is gone, the exits it did not report yet will never be.
+        bool IsOperational() {
+            _adminLock.Lock();
+            const bool result = (_helper.IsActive() == true);
+            _adminLock.Unlock();
+
+            return (result);
+        }
+        // Did the child exit, wait at most waitTime (ms) for it to happen.
+        bool Exited(const uint32_t pid, int& status, struct rusage& usage, const uint32_t waitTime) {
+            const uint64_t end = Core::Time::Now().Ticks() + (static_cast<uint64_t>(waitTime) * Core::Time::TicksPerMillisecond);
+            bool result = false;
+            bool waiting = true;
+
+            while (waiting == true) {
+                ZygoteMessage message;
+
+                _adminLock.Lock();
+
+                // Collect all that was reported so far.
+                while (Receive(message, 0) == true) {
+                }
+
+                Exits::iterator index(_exits.find(pid));
+
+                if (index != _exits.end()) {
+                    status = index->second.Status;
+                    usage = index->second.Usage;
+                    _exits.erase(index);
+                    result = true;
+                }
+
+                _adminLock.Unlock();
+
+                const uint64_t now = Core::Time::Now().Ticks();
+
+                if ((result == true) || (now >= end)) {
+                    waiting = false;
+                }
+                else {
+                    // Other jobs share the zygote, so do not hold the lock while waiting.
+                    const uint64_t left = (end - now) / Core::Time::TicksPerMillisecond;
+                    struct pollfd descriptor = { _socket, POLLIN, 0 };
+
+                    ::poll(&descriptor, 1, static_cast<int>(left > PollTime ? PollTime : (left == 0 ? 1 : left)));
+                }
+            }
+
+            return (result);
+        }
+
+    private:
+        bool Send(const string& message, const int descriptor) {
+            struct iovec vector = { const_cast<char*>(message.data()), message.length() };
+            union {
+                struct cmsghdr header;
+                char buffer[CMSG_SPACE(sizeof(int))];
+            } control;
+            struct msghdr packet;
+
+            ::memset(&packet, 0, sizeof(packet));
+            packet.msg_iov = &vector;
+            packet.msg_iovlen = 1;
+
+            if (descriptor != -1) {
+                ::memset(&control, 0, sizeof(control));
+                packet.msg_control = control.buffer;
+                packet.msg_controllen = sizeof(control.buffer);
+
+                struct cmsghdr* header = CMSG_FIRSTHDR(&packet);
+                header->cmsg_level = SOL_SOCKET;
+                header->cmsg_type = SCM_RIGHTS;
+                header->cmsg_len = CMSG_LEN(sizeof(int));
+                ::memcpy(CMSG_DATA(header), &descriptor, sizeof(int));
+            }
+
+            return (::sendmsg(_socket, &packet, MSG_NOSIGNAL) == static_cast<ssize_t>(message.length()));
+        }
+        // Exits are kept until they are asked for, the rest is returned.
+        bool Receive(ZygoteMessage& message, const uint32_t waitTime) {
+            struct pollfd descriptor = { _socket, POLLIN, 0 };
+            uint8_t buffer[sizeof(ZygoteMessage) + sizeof(struct rusage)];
+            ssize_t length;
+            bool result = false;
+
+            if ((_socket != -1) && (::poll(&descriptor, 1, waitTime) == 1) && ((length = ::recv(_socket, buffer, sizeof(buffer), MSG_DONTWAIT)) >= static_cast<ssize_t>(sizeof(message)))) {
+                ::memcpy(&message, buffer, sizeof(message));
+
+                if (message.Command == ZygoteMessage::EXITED) {
+                    Exit& exit(_exits[message.Pid]);
+
+                    exit.Status = message.Value;
+
+                    if (length == sizeof(buffer)) {
+                        ::memcpy(&exit.Usage, &(buffer[sizeof(message)]), sizeof(exit.Usage));
+                    }
+                    else {
+                        ::memset(&exit.Usage, 0, sizeof(exit.Usage));
+                    }
+                }
+                result = true;
+            }
+
+            return (result);
+        }
+
+    private:
+        Core::CriticalSection _adminLock;
+        ChildProcess _helper;
+        int _socket;
+        Exits _exits;
+    };
+
+public:
+    // Hierarchical timer wheel, with a resolution of a second, holding the next launch of all jobs.
+    // Adding or removing a timer is O(1), the due ones fire in batches from a single worker pool job,
+    // so the timer queue of the worker pool does not grow with the number of jobs.
+    class TimerWheel {
+    private:
+        struct Link {
+            Link* Previous;
+            Link* Next;
+        };
+
+        static constexpr uint8_t Bits = 6;
+        static constexpr uint32_t Slots = (1 << Bits);
+        static constexpr uint32_t Mask = (Slots - 1);
+        static constexpr uint8_t Levels = 4;
+        static constexpr uint64_t Range = (static_cast<uint64_t>(1) << (Bits * Levels));
+        static constexpr uint64_t Idle = ~static_cast<uint64_t>(0);
+        static constexpr uint64_t TicksPerSecond = (static_cast<uint64_t>(Core::Time::TicksPerMillisecond) * 1000);
+
+    public:
+        class Entry : private Link {
+        private:
+            friend class TimerWheel;
+
+        public:
+            Entry()
+                : Link { nullptr, nullptr }
+                , _expiry(0)
+            {
+            }
+            virtual ~Entry() = default;
+
+            // Called with the wheel locked, so keep it short.
+            virtual void Expired() = 0;
+
+        private:
+            uint64_t _expiry;
+        };
+
+    public:
+        TimerWheel(const TimerWheel&) = delete;
+        TimerWheel& operator=(const TimerWheel&) = delete;
+
+        TimerWheel()
+            : _adminLock()
+            , _current(Core::Time::Now().Ticks() / TicksPerSecond)
+            , _wake(Idle)
+            , _count(0)
+            , _driver(*this)
+        {
+            for (uint8_t level = 0; level < Levels; level++) {
+                for (uint32_t slot = 0; slot < Slots; slot++) {
+                    _slots[level][slot].Previous = &(_slots[level][slot]);
+                    _slots[level][slot].Next = &(_slots[level][slot]);
+                }
+            }
+        }
+        ~TimerWheel()
+        {
+            _driver.Revoke();
+        }
+
+    public:
+        void Close() {
+            _driver.Revoke();
+
+            _adminLock.Lock();
+            _wake = Idle;
+            _adminLock.Unlock();
+        }
+        // (Re)schedule the entry, it never fires before the given time.
+        void Schedule(Entry* entry, const Core::Time& time) {
+            const uint64_t expiry = (time.Ticks() + TicksPerSecond - 1) / TicksPerSecond;
+
+            _adminLock.Lock();
+
+            if (entry->Next != nullptr) {
+                Unlink(entry);
+            }
+            else if (_count++ == 0) {
+                // Nothing to catch up with, so start at the current time.
+                _current = std::max(_current, Core::Time::Now().Ticks() / TicksPerSecond);
+            }
+
+            entry->_expiry = std::max(expiry, _current);
+            Insert(entry);
+
+            if (entry->_expiry < _wake) {
+                _wake = entry->_expiry;
+                _driver.Reschedule(Core::Time(_wake * TicksPerSecond));
+            }
+
+            _adminLock.Unlock();
+        }
+        void Cancel(Entry* entry) {
+            _adminLock.Lock();
+
+            if (entry->Next != nullptr) {
+                Unlink(entry);
+                _count--;
+            }
+
+            _adminLock.Unlock();
+        }
+
+    private:
+        string JobIdentifier() const
+        {
+            return (_T("Launcher::TimerWheel"));
+        }
+
+        friend Core::ThreadPool::JobType<TimerWheel&>;
+        void Dispatch()
+        {
+            Advance(Core::Time::Now().Ticks() / TicksPerSecond);
+        }
+        // Fire everything that is due up to and including the given second.
+        void Advance(const uint64_t now)
+        {
+            _adminLock.Lock();
+
+            while (_current <= now) {
+                const uint32_t index = static_cast<uint32_t>(_current & Mask);
+
+                if (index == 0) {
+                    Cascade(1);
+                }
+
+                Link& slot(_slots[0][index]);
+
+                while (slot.Next != &slot) {
+                    Entry* entry = static_cast<Entry*>(slot.Next);
+
+                    Unlink(entry);
+                    _count--;
+                    entry->Expired();
+                }
+
+                _current++;
+            }
+
+            _wake = Next();
+
+            if (_wake != Idle) {
+                _driver.Reschedule(Core::Time(_wake * TicksPerSecond));
+            }
+
+            _adminLock.Unlock();
+        }
+        // The entries of the current slot of this level move down, the time has come to be more precise.
+        void Cascade(const uint8_t level) {
+            const uint32_t index = static_cast<uint32_t>((_current >> (Bits * level)) & Mask);
+
+            if ((index == 0) && ((level + 1) < Levels)) {
+                Cascade(level + 1);
+            }
+
+            Link& slot(_slots[level][index]);
+
+            while (slot.Next != &slot) {
+                Entry* entry = static_cast<Entry*>(slot.Next);
+
+                Unlink(entry);
+                Insert(entry);
+            }
+        }
+        void Insert(Entry* entry) {
+            const uint64_t delta = std::min(entry->_expiry - _current, Range - 1);
+            const uint64_t expiry = _current + delta;
+            uint8_t level = 0;
+
+            while ((level < (Levels - 1)) && (delta >= (static_cast<uint64_t>(1) << (Bits * (level + 1))))) {
+                level++;
+            }
+
+            Link& slot(_slots[level][(expiry >> (Bits * level)) & Mask]);
+
+            entry->Previous = slot.Previous;
+            entry->Next = &slot;
+            slot.Previous->Next = entry;
+            slot.Previous = entry;
+        }
+        static void Unlink(Entry* entry) {
+            entry->Previous->Next = entry->Next;
+            entry->Next->Previous = entry->Previous;
+            entry->Previous = nullptr;
+            entry->Next = nullptr;
+        }
+        // The first second something has to be done, firing or cascading.
+        uint64_t Next() const {
+            uint64_t result = Idle;
+
+            if (_count > 0) {
+                result = _current;
+
+                while (((result & Mask) != 0) && (_slots[0][result & Mask].Next == &(_slots[0][result & Mask]))) {
+                    result++;
+                }
+            }
+
+            return (result);
+        }
+
+    private:
+        Core::CriticalSection _adminLock;
+        Link _slots[Levels][Slots];
+        uint64_t _current;
+        uint64_t _wake;
+        uint32_t _count;
+
+        Core::WorkerPool::JobType<TimerWheel&> _driver;
+    };
+
+    // Limits the number of commands that run at the same time. The ones that have to wait for a
+    // slot are admitted in order of arrival, or in order of priority.
+    class Pool {
+    public:
+        struct IClient {
+            virtual ~IClient() {}
+
+            virtual uint8_t Priority() const = 0;
+
+            // A slot was handed over, the client owns it now.
+            virtual void Admitted() = 0;
+        };
+
+    public:
+        Pool(const Pool&) = delete;
+        Pool& operator=(const Pool&) = delete;
+
+        Pool()
+            : _adminLock()
+            , _parallelism(0)
+            , _order(FIFO)
+            , _running(0)
+            , _queue()
+            , _closed(true)
+        {
+        }
+        ~Pool() = default;
+
+    public:
+        // A parallelism of 0 means no limit.
+        void Open(const uint8_t parallelism, const order ordering) {
+            _adminLock.Lock();
+            _parallelism = parallelism;
+            _order = ordering;
+            _running = 0;
+            _closed = false;
+            _adminLock.Unlock();
+        }
+        void Close() {
+            _adminLock.Lock();
+            _closed = true;
+            _queue.clear();
+            _adminLock.Unlock();
+        }
+        // Returns true if a slot is taken, if not, the client is queued.
+        bool Acquire(IClient* client) {
+            bool result = false;
+
+            _adminLock.Lock();
+
+            if (_closed == true) {
+            }
+            else if ((_parallelism == 0) || (_running < _parallelism)) {
+                _running++;
+                result = true;
+            }
+            else if (std::find(_queue.begin(), _queue.end(), client) == _queue.end()) {
+                _queue.push_back(client);
+            }
+
+            _adminLock.Unlock();
+
+            return (result);
+        }
+        void Release() {
+            IClient* next = nullptr;
+
+            _adminLock.Lock();
+
+            if ((_closed == false) && (_queue.empty() == false)) {
+                std::vector<IClient*>::iterator selected(_queue.begin());
+
+                if (_order == PRIORITY) {
+                    // The first one of the highest priority, so equal priorities remain in order.
+                    for (std::vector<IClient*>::iterator index(_queue.begin()); index != _queue.end(); index++) {
+                        if ((*index)->Priority() > (*selected)->Priority()) {
+                            selected = index;
+                        }
+                    }
+                }
+
+                next = *selected;
+                _queue.erase(selected);
+            }
+            else if (_running > 0) {
+                _running--;
+            }
+
+            _adminLock.Unlock();
+
+            // The slot is handed over as is.
+            if (next != nullptr) {
+                next->Admitted();
+            }
+        }
+
+    private:
+        Core::CriticalSection _adminLock;
+        uint8_t _parallelism;
+        order _order;
+        uint8_t _running;
+        std::vector<IClient*> _queue;
+        bool _closed;
+    };
+
+    // Tells whether the system is under pressure, from the pressure stall information of the kernel.
+    // A trigger per resource makes the kernel report a stall over the threshold within a window, so
+    // nothing needs to be read periodically. While the triggers keep firing, the pressure is high.
+    class PressureGate {
+    public:
+        static constexpr uint32_t Window = 2000; // ms, as unprivileged triggers need a multiple of 2s
+
+    private:
+        class Trigger : public Core::IResource {
+        public:
+            Trigger() = delete;
+            Trigger(const Trigger&) = delete;
+            Trigger& operator=(const Trigger&) = delete;
+
+            Trigger(const TCHAR resource[])
+                : _resource(resource)
+                , _fd(-1)
+                , _fired(0)
+            {
+            }
+            ~Trigger() override
+            {
+                Close();
+            }
+
+        public:
+            // The percentage of the window some tasks may stall on the resource.
+            uint32_t Open(const uint8_t threshold) {
+                uint32_t result = Core::ERROR_NONE;
+
+                if (threshold != 0) {
+                    const uint64_t stall = (static_cast<uint64_t>(std::min(threshold, static_cast<uint8_t>(100))) * Window * 1000) / 100;
+                    const string trigger(_T("some ") + Core::NumberType<uint64_t>(stall).Text() + ' ' + Core::NumberType<uint32_t>(Window * 1000).Text());
+
+                    _fd = ::open((string(_T("/proc/pressure/")) + _resource).c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+
+                    // The terminating '\0' is part of it.
+                    if ((_fd == -1) || (::write(_fd, trigger.c_str(), trigger.length() + 1) < 0)) {
+                        TRACE(Trace::Error, (_T("Could not set a pressure trigger on %s, error: %d."), _resource, errno));
+                        Close();
+                        result = Core::ERROR_UNAVAILABLE;
+                    }
+                    else {
+                        Core::ResourceMonitor::Instance().Register(*this);
+                    }
+                }
+
+                return (result);
+            }
+            void Close() {
+                if (_fd != -1) {
+                    Core::ResourceMonitor::Instance().Unregister(*this);
+                    ::close(_fd);
+                    _fd = -1;
+                }
+            }
+            // It fires at most once per window, as long as the stall is over the threshold.
+            bool Fired(const uint64_t since) const {
+                return ((_fd != -1) && (_fired.load() >= since));
+            }
+
+        private:
+            handle Descriptor() const override {
+                return (_fd);
+            }
+            uint16_t Events() override {
+                return (POLLPRI);
+            }
+            void Handle(const uint16_t events) override {
+                if ((events & POLLPRI) != 0) {
+                    _fired = Core::Time::Now().Ticks();
+                }
+            }
+
+        private:
+            const TCHAR* _resource;
+            int _fd;
+            std::atomic<uint64_t> _fired;
+        };
+
+    public:
+        PressureGate(const PressureGate&) = delete;
+        PressureGate& operator=(const PressureGate&) = delete;
+
+        PressureGate()
+            : _cpu(_T("cpu"))
+            , _memory(_T("memory"))
+            , _io(_T("io"))
+            , _maxDelay(0)
+        {
+        }
+        ~PressureGate() = default;
+
+    public:
+        // Without any threshold, there is no gate.
+        uint32_t Open(const uint8_t cpu, const uint8_t memory, const uint8_t io, const uint16_t maxDelay) {
+            uint32_t result = _cpu.Open(cpu);
+
+            if (result == Core::ERROR_NONE) {
+                result = _memory.Open(memory);
+            }
+            if (result == Core::ERROR_NONE) {
+                result = _io.Open(io);
+            }
+            if (result != Core::ERROR_NONE) {
+                Close();
+            }
+
+            _maxDelay = maxDelay;
+
+            return (result);
+        }
+        void Close() {
+            _cpu.Close();
+            _memory.Close();
+            _io.Close();
+        }
+        bool Congested() const {
+            // Allow for a window of delay in the reporting.
+            const uint64_t since = Core::Time::Now().Ticks() - (static_cast<uint64_t>(2 * Window) * Core::Time::TicksPerMillisecond);
+
+            return ((_cpu.Fired(since) == true) || (_memory.Fired(since) == true) || (_io.Fired(since) == true));
+        }
+        uint16_t MaxDelay() const {
+            return (_maxDelay);
+        }
+
+    private:
+        Trigger _cpu;
+        Trigger _memory;
+        Trigger _io;
+        uint16_t _maxDelay; // s
+    };
+
+    // When, and how often, a command runs.
+    struct Plan {
+        Core::Time Start;
+        Time Interval;
+        Cron Calendar;
+        Scheduling Tuning;
+    };
+
+    // What all Jobs of the plugin share. The settings are only looked at while the Jobs are constructed.
+    struct Context {
+        const Config& Settings;
+        Pool& Launches;
+        TimerWheel& Timers;
+        PressureGate& Gate;
+        MemoryObserverImpl* Memory;
+        Zygote* Spawner;
+        // Without an observer, the processes are contained in control groups.
+        ProcessObserver* Observer;
+        ProcessObserver::IProcessState* Owner;
+    };
+
+    class Job : public ControlGroup::ICallback, public Pool::IClient, public TimerWheel::Entry {
+    private:
+        typedef std::unordered_set<uint32_t> ProcessList;
+
+        static constexpr uint32_t ReportTime = 100; // ms
+        static constexpr uint32_t ReapTime = 10; // ms
+        static constexpr uint32_t KillTime = 1000; // ms
+
+        // A step in stopping the processes. The next one is taken once the processes it targets
+        // are gone, or its time is up.
+        struct Rung {
+            int Signal;
+            target Target;
+            uint32_t Timeout; // ms
+        };
+
+        typedef std::vector<Rung> Ladder;
+
+        // What is kept of a completed run, in a ring of a fixed size, so recording it never allocates.
+        struct Outcome {
+            uint64_t Start; // ticks
+            uint32_t Latency; // ms
+            uint32_t Duration; // ms
+            uint32_t ExitCode;
+            uint32_t Processes;
+            uint8_t Stop;
+            bool Killed;
+            Usage Used;
+        };
+
+        static constexpr uint8_t HistorySize = 16;
+
+        // A single run of the command, with all the processes it started.
+        class Instance {
+        public:
+            Instance() = delete;
+            Instance(const Instance&) = delete;
+            Instance& operator=(const Instance&) = delete;
+
+            Instance(const ChildProcess& prototype, Zygote* zygote)
+                : Process(prototype.Command())
+                , Pid(0)
+                , Tree()
+                , Started(Core::Time::Now())
+                , Ended()
+                , Latency(0)
+                , Peak(1)
+                , Stop(0)
+                , Killed(false)
+                , Baseline()
+                , Contained()
+            {
+                for (uint32_t index = 1; index < prototype.Arguments().size(); index++) {
+                    Process.Add(prototype.Arguments()[index]);
+                }
+                Process.Redirect(prototype.Output());
+                Process.Constrain(prototype.Constraints());
+                Process.Delegate(zygote);
+            }
+            ~Instance() = default;
+
+        public:
+            ChildProcess Process;
+            uint32_t Pid;
+            ProcessList Tree;
+            Core::Time Started;
+            Core::Time Ended;
+            // From the moment it was due, till it was launched.
+            uint32_t Latency;
+            uint32_t Peak;
+            // The step of the stop ladder that ended it, zero if it ended by itself.
+            uint8_t Stop;
+            // Killed to make room for the next run, so how it ended does not count.
+            bool Killed;
+            // The counters of the control group at the launch, and what was added till the group emptied.
+            Usage Baseline;
+            Usage Contained;
+        };
+
+        typedef std::list<Instance> Instances;
+
+        // Looks again for the exits that were not collected yet, apart from the job, which also
+        // times the stop and the restarts.
+        class Reaper {
+        public:
+            Reaper() = delete;
+            Reaper(const Reaper&) = delete;
+            Reaper& operator=(const Reaper&) = delete;
+
+            explicit Reaper(Job& parent)
+                : _parent(parent)
+            {
+            }
+            ~Reaper() = default;
+
+        private:
+            friend Core::ThreadPool::JobType<Reaper&>;
+            void Dispatch()
+            {
+                _parent._owner->Reap();
+            }
+
+        private:
+            Job& _parent;
+        };
+
+    public:
+        Job() = delete;
+        Job(const Job&) = delete;
+        Job& operator=(const Job&) = delete;
+
+        // Without an observer, the processes are contained in the given control group.
+        Job(const Context& context, const Config::Entry& entry, const Plan& plan, const string& group)
+            : _adminLock()
+            , _process(entry.Command.Value())
+            , _pool(context.Launches)
+            , _wheel(context.Timers)
+            , _gate(context.Gate)
+            , _memory(context.Memory)
+            , _zygote(context.Spawner)
+            , _observer(context.Observer)
+            , _owner(context.Owner)
+            , _group(group, this)
+            , _cpuMax(entry.Limits.CpuMax.Value())
+            , _ioMax()
+            , _capture(entry.Capture.Buffer.Value(), entry.Capture.File.Value(), entry.Capture.Size.Value(), entry.Capture.Files.Value())
+            , _interval(plan.Interval)
+            , _calendar(plan.Calendar)
+            , _ladder()
+            , _step(0)
+            , _deadline()
+            , _priority(entry.Priority.Value())
+            , _catchUp(entry.ScheduleTime.CatchUp.Value())
+            , _overlap(entry.Overlap.Value())
+            , _concurrency(entry.Overlap.Value() == CONCURRENT ? std::max(entry.Concurrency.Value(), static_cast<uint8_t>(1)) : 1)
+            , _supervision(entry.Restart.Policy.Value())
+            , _backoff(entry.Restart.Backoff.Value())
+            , _maxBackoff(std::max(entry.Restart.MaxBackoff.Value(), entry.Restart.Backoff.Value()))
+            , _retries(entry.Restart.Retries.Value())
+            , _window(entry.Restart.Window.Value())
+            , _delay(entry.Restart.Backoff.Value())
+            , _attempts()
+            , _respawning(false)
+            , _respawns(0)
+            , _critical(entry.Critical.Value())
+            , _deferredSince()
+            , _deferred(0)
+            , _splay(0)
+            , _due()
+            , _dispatched()
+            , _history()
+            , _recorded(0)
+            , _usage()
+            , _epoch()
+            , _tick(0)
+            , _shutdownPhase(0)
+            , _pid(0)
+            , _runs(0)
+            , _pending(false)
+            , _skipped(0)
+            , _restarted(0)
+            , _completed(0)
+            , _lastDuration(0)
+            , _maxDuration(0)
+            , _totalDuration(0)
+            , _instances()
+            , _finished()
+            , _processListEmpty(1, 1)
+            , _shutdownCompleted(false)
+            , _reaping(*this)
+            , _job(*this)
+            , _reaper(_reaping)
+        {
+            auto iter = entry.Parameters.Elements();
+
+            while (iter.Next() == true) {
+                const Config::Parameter& element(iter.Current());
+
+                if ((element.Option.IsSet() == true) && (element.Option.Value().empty() == false)) {
+                    if ((element.Value.IsSet() == true) && (element.Value.Value().empty() == false)) {
+                        _process.Add(element.Option.Value());
+                        _process.Add(element.Value.Value());
+                    }
+                    else {
+                        _process.Add(element.Option.Value());
+                    }
+                }
+            }
+
+            auto device = entry.Limits.IoMax.Elements();
+
+            while (device.Next() == true) {
+                _ioMax.push_back(device.Current().Value());
+            }
+
+            _process.Constrain(plan.Tuning);
+
+            if ((_group.IsValid() == false) && ((_cpuMax.empty() == false) || (_ioMax.empty() == false))) {
+                TRACE(Trace::Warning, (_T("The limits of %s require a control group, they are ignored."), _process.Command().c_str()));
+            }
+
+            if (entry.ScheduleTime.Splay.Value() != 0) {
+                // Drawn once, so the runs stay on a grid, just not the same one on every device.
+                std::random_device seed;
+                _splay = std::uniform_int_distribution<uint64_t>(0, static_cast<uint64_t>(entry.ScheduleTime.Splay.Value()) * Time::MilliSecondsPerSecond * Core::Time::TicksPerMillisecond)(seed);
+            }
+
+            auto step = context.Settings.Stop.Elements();
+
+            while (step.Next() == true) {
+                _ladder.push_back({ static_cast<int>(step.Current().Signal.Value()), step.Current().Target.Value(), step.Current().Timeout.Value() });
+            }
+
+            if (_ladder.empty() == true) {
+                // First try a gentle touch, for the configured time, then do it the rude way.
+                _ladder.push_back({ SIGTERM, ROOT, context.Settings.CloseTime.Value() * Time::MilliSecondsPerSecond });
+                _ladder.push_back({ SIGKILL, TREE, KillTime });
+            }
+
+            if ((_group.IsValid() == true) && (_concurrency > 1)) {
+                // The group can not tell which run left, so they can not overlap.
+                TRACE(Trace::Warning, (_T("Concurrent runs of %s are not possible in a control group, running one at a time."), _process.Command().c_str()));
+                _concurrency = 1;
+            }
+
+            _memory->AddRef();
+
+            ASSERT((_observer != nullptr) ^ (_group.IsValid() == true));
+        }
+        ~Job() override
+        {
+            _wheel.Cancel(this);
+            _job.Revoke();
+            _reaper.Revoke();
+
+            ASSERT(_group.IsOpen() == false);
+
+            _capture.Close();
+            _memory->Release();
+        }
+
+    public:
+        uint32_t Open() {
+            uint32_t result = Core::ERROR_NONE;
+
+            if (_group.IsValid() == true) {
+                result = _group.Open();
+
+                if ((result == Core::ERROR_NONE) && (_group.Limit(_cpuMax, _ioMax) == false)) {
+                    TRACE(Trace::Error, (_T("Could not limit control group %s, error: %d."), _group.Path().c_str(), errno));
+                    _group.Close();
+                    result = Core::ERROR_BAD_REQUEST;
+                }
+                if (result == Core::ERROR_NONE) {
+                    _memory->Observe(&_group);
+                }
+            }
+            if ((result == Core::ERROR_NONE) && (_capture.IsValid() == true)) {
+                result = _capture.Open();
+
+                if (result == Core::ERROR_NONE) {
+                    _process.Redirect(_capture.Sink());
+                }
+            }
+
+            return (result);
+        }
+        // Nothing of the control group is reported anymore after this, so the owner can let go of us.
+        void Close() {
+            if (_group.IsValid() == true) {
+                _memory->Forget(&_group);
+                _group.Close();
+            }
+        }
+        // The result of the runs that completed since the last call, the first failure if there is one.
+        // This is called on the threads delivering the events, so it never waits for an exit. A run of
+        // which the exit is not there yet, is looked at again a little later.
+        uint32_t ExitCode() {
+            uint32_t result = Core::ERROR_NONE;
+            Instances finished;
+
+            _adminLock.Lock();
+            finished.splice(finished.end(), _finished);
+            _adminLock.Unlock();
+
+            Instances::iterator instance(finished.begin());
+
+            while (instance != finished.end()) {
+                // The tree is gone, but the root might not be a zombie yet, or a zygote might not have 
+                // reported its exit yet.
+                if (instance->Process.IsActive() == true) {
+                    instance++;
+                }
+                else {
+                    Record(*instance);
+
+                    if ((instance->Killed == false) && (Supervise(*instance, instance->Process.ExitCode()) == false) && (result == Core::ERROR_NONE)) {
+                        result = instance->Process.ExitCode();
+                    }
+
+                    instance = finished.erase(instance);
+                }
+            }
+
+            if (finished.empty() == false) {
+                _adminLock.Lock();
+                _finished.splice(_finished.begin(), finished);
+                _adminLock.Unlock();
+
+                _reaper.Reschedule(Core::Time::Now().Add(ReapTime));
+            }
+
+            return (result);
+        }
+        // Runs ended, but not all of their exits are collected yet.
+        bool Reaping() const {
+            _adminLock.Lock();
+            const bool result = (_finished.empty() == false);
+            _adminLock.Unlock();
+
+            return (result);
+        }
+        const string& Command() const {
+            return (_process.Command());
+        }
+        bool Captured() const {
+            return (_capture.IsValid());
+        }
+        void Tail(string& output, const uint32_t length) {
+            _capture.Tail(output, length);
+        }
+        bool IsActive() const {
+            return (_instances.empty() == false);
+        }
+        bool Continuous() const {
+            return ((_interval.IsValid() == true) || (_calendar.IsValid() == true));
+        }
+        // A single shot that has run completely, and of which it is known how it ended.
+        bool Finished() const {
+            return ((Continuous() == false) && (_runs > 0) && (IsActive() == false) && (_respawning == false) && (Reaping() == false));
+        }
+        uint32_t Pid() const {
+            return (_pid);
+        }
+        void Report(Statistics::Activity& activity) const {
+            _adminLock.Lock();
+
+            activity.Command = _process.Command();
+            activity.Runs = _runs;
+            activity.Active = static_cast<uint32_t>(_instances.size());
+            activity.Skipped = _skipped;
+            activity.Restarted = _restarted;
+            activity.Respawns = _respawns;
+            activity.Deferred = _deferred;
+            activity.Duration.Last = _lastDuration;
+            activity.Duration.Max = _maxDuration;
+            activity.Duration.Average = (_completed == 0 ? 0 : _totalDuration / _completed);
+            activity.Usage.Set(_usage);
+
+            for (uint32_t index = (_recorded > HistorySize ? _recorded - HistorySize : 0); index < _recorded; index++) {
+                const Outcome& record(_history[index % HistorySize]);
+                Statistics::Run& run(activity.History.Add());
+
+                run.Start = Core::Time(record.Start).ToISO8601();
+                run.Latency = record.Latency;
+                run.Duration = record.Duration;
+                run.ExitCode = record.ExitCode;
+                run.Processes = record.Processes;
+                run.Stop = record.Stop;
+                run.Killed = record.Killed;
+                run.Usage.Set(record.Used);
+            }
+
+            _adminLock.Unlock();
+        }
+        // All observed events pass by all jobs, returns true if it concerned our tree.
+        bool Update (const ProcessObserver::Info& info) {
+            bool result = false;
+            bool completed = false;
+            bool pending = false;
+
+            switch (info.Event()) {
+            case ProcessObserver::Info::EVENT_FORK:
+            {
+                 _adminLock.Lock();
+
+                 Instances::iterator instance(Owner(info.Group()));
+
+                 if (instance != _instances.end()) {
+                     if (instance->Tree.insert(info.ChildId()).second == true) {
+                         _memory->Add(info.ChildId());
+                         instance->Peak = std::max(instance->Peak, static_cast<uint32_t>(instance->Tree.size()));
+                     }
+
+                     if ((Killing() == true) || (instance->Killed == true)) {
+                         ::kill(info.ChildId(), SIGKILL);
+                     }
+                     result = true;
+                 }
+
+                 _adminLock.Unlock();
+                 break;
+            }
+            case ProcessObserver::Info::EVENT_EXIT:
+            {
+                _adminLock.Lock();
+
+                Instances::iterator instance(Owner(info.Id()));
+
+                if (instance != _instances.end()) {
+                    instance->Tree.erase(info.Id());
+                    _memory->Remove(info.Id());
+                    if (instance->Tree.empty() == true) {
+                        pending = Conclude(instance);
+                        completed = true;
+                    }
+                    Progress();
+                    result = true;
+                }
+
+                _adminLock.Unlock();
+                break;
+            }
+            default:
+                break;
+            }
+
+            if (completed == true) {
+                Proceed(pending);
+            }
+
+            return (result);
+        }
+        // Events got lost, so rebuild the tree from what is actually running. Processes we know of
+        // that are still alive are kept, together with all their current descendants.
+        void Resync() {
+            uint32_t completed = 0;
+            bool pending = false;
+
+            if (_group.IsValid() == true) {
+                // Nothing to rebuild, the group knows if anything is left.
+                _adminLock.Lock();
+
+                if ((_instances.empty() == false) && (_group.Populated() == false)) {
+                    while (_instances.empty() == false) {
+                        pending = Conclude(_instances.begin()) || pending;
+                        completed++;
+                    }
+                }
+                else if (_instances.empty() == false) {
+                    // Only the group knows how many processes there are.
+                    std::vector<uint32_t> pids;
+                    _group.Pids(pids);
+                    _instances.front().Peak = std::max(_instances.front().Peak, static_cast<uint32_t>(pids.size()));
+                }
+
+                Progress();
+
+                _adminLock.Unlock();
+            }
+            else {
+                ProcessTree::Parents parents;
+                ProcessTree::Snapshot(parents);
+
+                _adminLock.Lock();
+
+                Instances::iterator instance(_instances.begin());
+
+                while (instance != _instances.end()) {
+                    ProcessList current;
+
+                    for (const uint32_t pid : instance->Tree) {
+                        if (parents.find(pid) != parents.end()) {
+                            current.insert(pid);
+                        }
+                    }
+
+                    ProcessTree::Descendants(parents, current);
+
+                    for (const uint32_t pid : instance->Tree) {
+                        if (current.find(pid) == current.end()) {
+                            _observer->Untrack(pid);
+                            _memory->Remove(pid);
+                        }
+                    }
+                    for (const uint32_t pid : current) {
+                        if (instance->Tree.find(pid) == instance->Tree.end()) {
+                            _observer->Track(pid, _owner);
+                            _memory->Add(pid);
+
+                            if ((Killing() == true) || (instance->Killed == true)) {
+                                ::kill(pid, SIGKILL);
+                            }
+                        }
+                    }
+
+                    TRACE(Trace::Information, (_T("Resynced [%s], tracking %d processes (was %d)."), _process.Command().c_str(), static_cast<uint32_t>(current.size()), static_cast<uint32_t>(instance->Tree.size())));
+
+                    instance->Tree.swap(current);
+                    instance->Peak = std::max(instance->Peak, static_cast<uint32_t>(instance->Tree.size()));
+
+                    if (instance->Tree.empty() == true) {
+                        Instances::iterator concluded(instance++);
+                        pending = Conclude(concluded) || pending;
+                        completed++;
+                    }
+                    else {
+                        instance++;
+                    }
+                }
+
+                Progress();
+
+                _adminLock.Unlock();
+            }
+
+            while (completed-- > 0) {
+                Proceed(pending);
+                pending = false;
+            }
+        }
+        // All runs are planned relative to this first one.
+        void Schedule (const Core::Time& time) {
+            _epoch = time;
+            _tick = 0;
+
+            const Core::Time first(time.Ticks() + _splay);
+
+            _due = first;
+
+            if (first <= Core::Time::Now()) {
+                _job.Submit();
+            }
+            else {
+                _wheel.Schedule(this, first);
+            }
+        }
+        // Starts to stop all runs, by climbing the ladder of signals. It proceeds on the process events
+        // and the timeouts of the steps, returns the moment it should have completed.
+        Core::Time Terminate() {
+            uint32_t waitTime = KillTime;
+
+            _adminLock.Lock();
+            _shutdownPhase = 1;
+            _pending = false;
+            _adminLock.Unlock();
+
+            // Nothing may be launched from here on.
+            _wheel.Cancel(this);
+            _job.Revoke();
+
+            _adminLock.Lock();
+            _step = 0;
+            Climb();
+            _adminLock.Unlock();
+
+            for (const Rung& step : _ladder) {
+                waitTime += step.Timeout;
+            }
+
+            return (Core::Time::Now().Add(waitTime));
+        }
+        // Returns once all processes are gone, or are given up on.
+        void Wait(const Core::Time& deadline) {
+            const Core::Time now(Core::Time::Now());
+            const uint32_t waitTime = (deadline > now ? static_cast<uint32_t>((deadline.Ticks() - now.Ticks()) / Core::Time::TicksPerMillisecond) : 0);
+
+            if (_processListEmpty.Lock(waitTime) != Core::ERROR_NONE) {
+                _adminLock.Lock();
+                Abandon();
+                _adminLock.Unlock();
+            }
+
+            _wheel.Cancel(this);
+            _job.Revoke();
+
+            // Nobody is interested in how they ended anymore, but they need to be reaped. This is
+            // not a thread delivering events, so here it can be waited for.
+            Instances finished;
+
+            _adminLock.Lock();
+            finished.splice(finished.end(), _finished);
+            _adminLock.Unlock();
+
+            for (Instance& instance : finished) {
+                instance.Process.WaitProcessCompleted(ReportTime);
+                Record(instance);
+            }
+
+            _reaper.Revoke();
+
+            _adminLock.Lock();
+            _processListEmpty.Unlock();            
+            _shutdownPhase = 0;
+            _adminLock.Unlock();
+        }
+
+    private:
+        string JobIdentifier() const
+        {
+            return (_T("Launcher::Command(\"") + _process.Command() + _T("\")"));
+        }
+        // The populated state of the control group changed.
+        void Changed() override
+        {
+            _owner->Resync();
+        }
+        uint8_t Priority() const override
+        {
+            return (_priority);
+        }
+        // It was our turn in the pool.
+        void Admitted() override
+        {
+            Launch();
+        }
+        // Our launch time has come, the wheel is locked, so only submit the job.
+        void Expired() override
+        {
+            _job.Submit();
+        }
+        Instances::iterator Owner(const uint32_t pid)
+        {
+            Instances::iterator index(_instances.begin());
+
+            while ((index != _instances.end()) && (index->Tree.find(pid) == index->Tree.end())) {
+                index++;
+            }
+
+            return (index);
+        }
+        // Called with the lock taken, once the whole tree of a run is gone. Returns true if a run
+        // is waiting for this one to complete.
+        bool Conclude(Instances::iterator instance)
+        {
+            instance->Ended = Core::Time::Now();
+            instance->Stop = (_shutdownPhase == 1 ? _step + 1 : 0);
+
+            if (_group.IsValid() == true) {
+                Usage current{};
+
+                _group.Consumed(current);
+
+                instance->Contained.User = current.User - instance->Baseline.User;
+                instance->Contained.System = current.System - instance->Baseline.System;
+                instance->Contained.Read = current.Read - instance->Baseline.Read;
+                instance->Contained.Written = current.Written - instance->Baseline.Written;
+            }
+
+            const uint64_t duration = (instance->Ended.Ticks() - instance->Started.Ticks()) / Core::Time::TicksPerMillisecond;
+            const bool pending = ((_pending == true) && (_shutdownPhase == 0));
+
+            _completed++;
+            _lastDuration = duration;
+            _maxDuration = std::max(_maxDuration, duration);
+            _totalDuration += duration;
+            _pending = false;
+
+            _finished.splice(_finished.end(), _instances, instance);
+
+            if (_instances.empty() == true) {
+                _processListEmpty.Unlock();
+            }
+
+            return (pending);
         }
+        // A run completed, its slot in the pool is given back, and a run that was waiting for it takes its place.
+        void Proceed(const bool pending)
+        {
+            _pool.Release();
 
-    private:
-        void Parse(const string& time) {
-            bool status = true;
-            string t = time;
+            if ((pending == true) && (_pool.Acquire(this) == true)) {
+                Launch();
+            }
+        }
+        // Called with the lock taken, the processes of a run, if there is a group, it knows them.
+        void Members(const Instance& instance, std::vector<uint32_t>& pids) const
+        {
+            if (_group.IsValid() == true) {
+                _group.Pids(pids);
+            }
+            else {
+                pids.insert(pids.end(), instance.Tree.begin(), instance.Tree.end());
+            }
+        }
+        // Called with the lock taken, returns true if any of the targeted processes is still there.
+        bool Remaining(const target what) const
+        {
+            bool result = false;
 
-            //Get hours
-            uint8_t hour = (~0);
-            string hValue = Split(t, ":");
-            if (hValue.empty() != true) {
-                status = IsValidTime(hValue, hour, HoursPerDay);
+            if (what == TREE) {
+                result = (_instances.empty() == false);
             }
-            if (status == true) {
-                //Get minutes
-                uint8_t minute = (~0);
-                string mValue = Split(t, ".");
-                if (mValue.empty() != true) {
-                    status = IsValidTime(mValue, minute, MinutesPerHour);
-                }
-                if (status == true) {
+            else {
+                for (Instances::const_iterator instance(_instances.begin()); (result == false) && (instance != _instances.end()); instance++) {
+                    std::vector<uint32_t> pids;
 
-                    //Store seconds
-                    uint8_t second = (~0);
-                    string sValue = t;
-                    if (sValue.empty() != true) {
-                        status = IsValidTime(sValue, second, SecondsPerMinute);
-                    }
-                    if (status  == true) {
+                    Members(*instance, pids);
 
-                        //Check all the time components are still valid
-                        if ((hour != static_cast<uint8_t>(~0) && second != static_cast<uint8_t>(~0)) && (minute == static_cast<uint8_t>(~0))) {
-                            TRACE(Trace::Information, (_T("Invalid time format: the given format is HH:MM.SS")));
-                        }
-                        else { //Update time components
-                            _hour = hour;
-                            _minute = minute;
-                            _second = second;
-                        }
+                    for (std::vector<uint32_t>::const_iterator pid(pids.begin()); (result == false) && (pid != pids.end()); pid++) {
+                        result = (what == ROOT ? (*pid == instance->Pid) : (::getpgid(*pid) == static_cast<pid_t>(instance->Pid)));
                     }
                 }
             }
-        }
 
-    private:
-        inline bool IsDigit(const string& str) {
-            return (str.find_first_not_of( "0123456789" ) == std::string::npos);
+            return (result);
         }
+        // Called with the lock taken.
+        void Deliver(const int signal, const target what)
+        {
+            if ((what == TREE) && (signal == SIGKILL) && (_group.IsValid() == true)) {
+                // Takes the whole tree at once, nothing can fork its way out of it.
+                _group.Kill();
+            }
+            else if (what == TREE) {
+                ProcessTree::Parents parents;
+                std::vector<uint32_t> pids;
 
-        inline bool IsValidTime(const string& str, uint8_t& time, const uint8_t limit) {
-            bool status = true;
-            if (IsDigit(str)) {
-                int t = atoi(str.c_str());
-                if (t >= limit || t < 0) {
-                    status = false;
-                    TRACE(Trace::Information, (_T("Invalid time  %s"), str.c_str()));
+                for (const Instance& instance : _instances) {
+                    Members(instance, pids);
                 }
-                else {
-                    time = t;
+
+                // The parents should not see their children die on them if they are asked to leave.
+                ProcessTree::Snapshot(parents);
+                ProcessTree::ChildrenFirst(parents, pids);
+
+                for (const uint32_t pid : pids) {
+                    ::kill(pid, signal);
                 }
             }
             else {
-                status = false;
-                TRACE(Trace::Information, (_T("Invalid time %s"), str.c_str()));
+                for (const Instance& instance : _instances) {
+                    ::kill(what == GROUP ? -static_cast<pid_t>(instance.Pid) : static_cast<pid_t>(instance.Pid), signal);
+                }
             }
-            return status;
         }
+        // Called with the lock taken, new processes are killed right away.
+        bool Killing() const
+        {
+            return ((_shutdownPhase == 1) && (_step < _ladder.size()) && (_ladder[_step].Signal == SIGKILL));
+        }
+        // Called with the lock taken, takes the current step, or the first one after it of which the
+        // targets are still there.
+        void Climb()
+        {
+            while ((_shutdownPhase == 1) && (_instances.empty() == false)) {
+                if (_step >= _ladder.size()) {
+                    Abandon();
+                }
+                else if (Remaining(_ladder[_step].Target) == false) {
+                    _step++;
+                }
+                else {
+                    const Rung& step(_ladder[_step]);
 
-        inline string Split(string& str, const string delimiter) {
-            string word;
-            size_t position = str.find(delimiter, 0);
-            if (position != string::npos) {
-                word = str.substr(0, position);
-                str = str.substr(word.size() + 1, str.size());
+                    TRACE(Trace::Information, (_T("Stopping %s, signal %d."), _process.Command().c_str(), step.Signal));
+                    Deliver(step.Signal, step.Target);
+
+                    _deadline = Core::Time::Now().Add(step.Timeout);
+                    _job.Reschedule(_deadline);
+                    break;
+                }
+            }
+        }
+        // Called with the lock taken, after processes left, the current step is done if all it targets left.
+        void Progress()
+        {
+            if ((_shutdownPhase == 1) && (_instances.empty() == false) && (_step < _ladder.size()) && (Remaining(_ladder[_step].Target) == false)) {
+                _step++;
+                Climb();
             }
-            return word;
         }
+        // Called with the lock taken, whatever is left can not be killed, stop tracking it.
+        void Abandon()
+        {
+            if (_instances.empty() == false) {
+                TRACE(Trace::Fatal, (_T("Could not kill all spawned processes for: %s."), _process.Command().c_str()));
 
-    private:
-        uint8_t _hour;
-        uint8_t _minute;
-        uint8_t _second;
-    };
+                if (_observer != nullptr) {
+                    for (const Instance& instance : _instances) {
+                        for (const uint32_t pid : instance.Tree) {
+                            _observer->Untrack(pid);
+                        }
+                    }
+                    _memory->Clear();
+                }
+                for (Instance& instance : _instances) {
+                    instance.Ended = Core::Time::Now();
+                    instance.Stop = static_cast<uint8_t>(_ladder.size());
+                }
+                _finished.splice(_finished.end(), _instances);
+                _processListEmpty.Unlock();
+            }
+            _shutdownPhase = 2;
+        }
+        // Called once the exit code of a run is known.
+        void Record(const Instance& instance)
+        {
+            _adminLock.Lock();
 
-public:
-    class Job {
-    private:
-        typedef std::vector<uint32_t> ProcessList;
+            Outcome& record(_history[_recorded % HistorySize]);
 
-    public:
-        Job() = delete;
-        Job(const Job&) = delete;
-        Job& operator=(const Job&) = delete;
+            record.Start = instance.Started.Ticks();
+            record.Latency = instance.Latency;
+            record.Duration = static_cast<uint32_t>((instance.Ended.Ticks() - instance.Started.Ticks()) / Core::Time::TicksPerMillisecond);
+            record.ExitCode = instance.Process.ExitCode();
+            record.Processes = instance.Peak;
+            record.Stop = instance.Stop;
+            record.Killed = instance.Killed;
+            record.Used = instance.Process.Resources();
 
-        Job(Config* config, const Time& interval, Exchange::IMemory* memory)
-            : _adminLock()
-            , _options(config->Command.Value().c_str())
-            , _process(false)
-            , _memory(memory)
-            , _interval(interval)
-            , _closeTime(config->CloseTime.Value())
-            , _shutdownPhase(0)
-            , _processListEmpty(1, 1)
-            , _shutdownCompleted(false)
-            , _job(*this)
+            // The group saw all processes, reaping only counts the descendants that were waited for.
+            record.Used.User = std::max(record.Used.User, instance.Contained.User);
+            record.Used.System = std::max(record.Used.System, instance.Contained.System);
+            record.Used.Read = std::max(record.Used.Read, instance.Contained.Read);
+            record.Used.Written = std::max(record.Used.Written, instance.Contained.Written);
+
+            _usage.Add(record.Used);
+
+            _recorded++;
+
+            _adminLock.Unlock();
+        }
+        // A run ended by itself, returns true if it is started again, instead of reporting how it ended.
+        // If it is scheduled, the next run on the schedule is the restart, so only a failure counts.
+        bool Supervise(const Instance& instance, const uint32_t exitCode)
         {
-            auto iter = config->Parameters.Elements();
+            bool result = false;
 
-            while (iter.Next() == true) {
-                const Config::Parameter& element(iter.Current());
+            if ((Continuous() == true) ? ((_supervision != NEVER) && (exitCode != Core::ERROR_NONE))
+                                       : ((_supervision == ALWAYS) || ((_supervision == ON_FAILURE) && (exitCode != Core::ERROR_NONE)))) {
+                const Core::Time now(Core::Time::Now());
+                const uint64_t window = static_cast<uint64_t>(_window) * Time::MilliSecondsPerSecond * Core::Time::TicksPerMillisecond;
 
-                if ((element.Option.IsSet() == true) && (element.Option.Value().empty() == false)) {
-                    if ((element.Value.IsSet() == true) && (element.Value.Value().empty() == false)) {
-                        _options.Add(element.Option.Value());
-                        _options.Add(element.Value.Value());
+                _adminLock.Lock();
+
+                if (_shutdownPhase == 0) {
+                    // Only the restarts within the window count against the budget.
+                    while ((_attempts.empty() == false) && ((_attempts.front().Ticks() + window) <= now.Ticks())) {
+                        _attempts.pop_front();
+                    }
+
+                    if ((now.Ticks() - instance.Started.Ticks()) >= window) {
+                        // It stayed up long enough to call it stable, so the backoff starts over.
+                        _delay = _backoff;
+                    }
+
+                    if (_attempts.size() >= _retries) {
+                        TRACE(Trace::Fatal, (_T("%s ended %d times within %d seconds, no more restarts."), _process.Command().c_str(), static_cast<uint32_t>(_attempts.size()) + 1, _window));
+                    }
+                    else if (Continuous() == true) {
+                        TRACE(Trace::Information, (_T("%s ended with %d, retrying it on the next scheduled run."), _process.Command().c_str(), exitCode));
+
+                        _attempts.push_back(now);
+                        _respawns++;
+
+                        result = true;
                     }
                     else {
-                        _options.Add(element.Option.Value());
+                        TRACE(Trace::Information, (_T("%s ended with %d, restarting it in %d ms."), _process.Command().c_str(), exitCode, _delay));
+
+                        _attempts.push_back(now);
+                        _respawns++;
+                        _respawning = true;
+                        _due = Core::Time(now).Add(_delay);
+                        _job.Reschedule(_due);
+                        _delay = static_cast<uint32_t>(std::min(static_cast<uint64_t>(_delay) * 2, static_cast<uint64_t>(_maxBackoff)));
+
+                        result = true;
                     }
                 }
+
+                _adminLock.Unlock();
             }
-            _memory->AddRef();
+
+            return (result);
         }
-        ~Job()
+        // Called with the lock taken, returns false if the run should wait for the pressure to drop, but
+        // not longer than allowed.
+        bool Admit()
         {
-            _job.Revoke();
-            _memory->Release();
-        }
+            bool result = true;
 
-    public:
-        uint32_t ExitCode() {
-            return (_process.IsActive() == false ? _process.ExitCode() : static_cast<uint32_t>(Core::ERROR_NONE));
-        }
-        bool IsActive() const {
-            return (_processList.size() > 0);
-        }
-        bool Continuous() const {
-            return (_interval.IsValid() == true);
-        }
-        uint32_t Pid() {
-            return (_processList.front());
-        }
-        void Update (const ProcessObserver::Info& info) {
-            switch (info.Event()) {
-            case ProcessObserver::Info::EVENT_FORK:
-            {
-                 _adminLock.Lock();
+            if ((_critical == false) && (_gate.Congested() == true)) {
+                const Core::Time now(Core::Time::Now());
+
+                if (_deferredSince.IsValid() == false) {
+                    TRACE(Trace::Information, (_T("The system is under pressure, deferring %s."), _process.Command().c_str()));
+                    _deferredSince = now;
+                    _deferred++;
+                    result = false;
+                }
+                else {
+                    result = ((now.Ticks() - _deferredSince.Ticks()) >= (static_cast<uint64_t>(_gate.MaxDelay()) * Time::MilliSecondsPerSecond * Core::Time::TicksPerMillisecond));
+                }
+            }
+            if (result == true) {
+                _deferredSince = Core::Time();
+            }
 
-                 ProcessList::iterator position (std::find(_processList.begin(), _processList.end(), info.Id()));
-                 if (position != _processList.end()) {
-                     _processList.push_back(info.ChildId());
+            return (result);
+        }
+        // Decides, according to the overlap policy, if a new run can be launched now.
+        bool Overlap()
+        {
+            bool result = false;
 
-                     if (_shutdownPhase == 2) {
-                         ::kill(info.ChildId(), SIGKILL);
-                     }
-                 }
+            _adminLock.Lock();
 
-                 _adminLock.Unlock();
-                 break;
+            if (_instances.size() < _concurrency) {
+                result = true;
             }
-            case ProcessObserver::Info::EVENT_EXIT:
-            {
-                _adminLock.Lock();
+            else if (_overlap == QUEUE) {
+                // One waits for the running one, others are lost.
+                if (_pending == true) {
+                    _skipped++;
+                }
+                _pending = true;
+            }
+            else if (_overlap == RESTART) {
+                TRACE(Trace::Information, (_T("Killing the running %s, to start it again."), _process.Command().c_str()));
 
-                ProcessList::iterator position (std::find(_processList.begin(), _processList.end(), info.Id()));
-                if (position != _processList.end()) {
-                    _processList.erase(position);
-                    if (_processList.size() == 0) {
-                        _processListEmpty.Unlock();
-                    }
+                for (Instance& instance : _instances) {
+                    instance.Killed = true;
                 }
+                Deliver(SIGKILL, TREE);
 
-                _adminLock.Unlock();
-                break;
-            }
-            default:
-                break;
-            }
-        }
-        void Schedule (const Core::Time& time) {
-            if (time <= Core::Time::Now()) {
-                _job.Submit();
+                _restarted++;
+                _pending = true;
             }
             else {
-                _job.Reschedule(time);
+                _skipped++;
             }
+
+            _adminLock.Unlock();
+
+            return (result);
         }
-        void Shutdown () {
+
+        friend Core::ThreadPool::JobType<Job&>;
+        void Dispatch()
+        {
             _adminLock.Lock();
-            _shutdownPhase = 1;
-            _adminLock.Unlock();
 
-            _job.Revoke();
-            if (_process.IsActive() == true) {
+            if (_shutdownPhase != 0) {
+                // Stopping, take the next step if the time of this one is up. A timer may fire a
+                // bit early, in that case wait for the rest of it, or the stop would stall here.
+                if ((_shutdownPhase == 1) && (_instances.empty() == false) && (_step < _ladder.size())) {
+                    if (_deadline.Ticks() <= (Core::Time::Now().Ticks() + Core::Time::TicksPerMillisecond)) {
+                        _step++;
+                        Climb();
+                    }
+                    else {
+                        _job.Reschedule(_deadline);
+                    }
+                }
+                _adminLock.Unlock();
+                return;
+            }
 
-                // First try a gentle touch....
-                _process.Kill(false);
+            if (Admit() == false) {
+                // Try again in a while, the next run is planned once this one is launched.
+                _wheel.Schedule(this, Core::Time::Now().Add(PressureGate::Window));
+                _adminLock.Unlock();
+                return;
+            }
+
+            // The run that is launched now, or later, was due at this moment.
+            _dispatched = _due;
+
+            _adminLock.Unlock();
+
+            TRACE(Trace::Information, (_T("Launcher: job is dispatched")));
 
-               // Wait for a maximum configured wait time before we shoot the process!!
-               _process.WaitProcessCompleted(_closeTime * 1000);
+             // Check if the previous run completed, no need to run the same job twice. If the
+             // pool is full, we are launched once it is our turn.
+            if ((Overlap() == true) && (_pool.Acquire(this) == true)) {
+                Launch();
             }
 
-            // If there was a proper shutdown, all assoicated processes should have left. 
-            // If not, we will start doing it the rude way!!
-            if (_processList.size() != 0) {
+            if (Continuous() == true) {
                 _adminLock.Lock();
-                _shutdownPhase = 2;
+                if (_shutdownPhase == 0) {
+                    // Reschedule our next launch point, on the grid, so the latency of this run does not add up.
+                    const Core::Time nextRun(Next(Core::Time::Now()));
 
-                TRACE(Trace::Information, (_T("Trying to force kill.")));
-                for (int i = 0; i < static_cast<int>(_processList.size()); i++) {
-                    ::kill(_processList[i], SIGKILL);
+                    if (nextRun.IsValid() == true) {
+                        _due = nextRun;
+                        _wheel.Schedule(this, nextRun);
+                    }
                 }
- 
                 _adminLock.Unlock();
-                _process.WaitProcessCompleted(1000);
             }
+        }
+        // Run n is at the first run + n x interval, the ticks that have passed already are caught up
+        // with as configured.
+        Core::Time Next(const Core::Time& now)
+        {
+            if (_calendar.IsValid() == true) {
+                // The calendar is the grid, the last run is where we are on it.
+                uint64_t grid = _calendar.Next(_epoch.Ticks());
 
-            if (_processListEmpty.Lock(1000) != Core::ERROR_NONE) {
-                TRACE(Trace::Fatal, (_T("Could not kill all spawned processes for: %s."), _options.Command().c_str()));
-                _processList.clear();
-            }
+                if ((grid != 0) && (_catchUp != ALL) && ((grid + _splay) <= now.Ticks())) {
+                    const uint64_t late = now.Ticks() - _splay;
 
-            _adminLock.Lock();
-            _processListEmpty.Unlock();            
-            _shutdownPhase = 0;
-            _adminLock.Unlock();
-        }
+                    grid = (_catchUp == ONCE ? late : _calendar.Next(late));
+                }
 
-    private:
-        string JobIdentifier() const
-        {
-            return (_T("Launcher::Command(\"") + _options.Command() + _T("\")"));
-        }
+                _epoch = (grid != 0 ? Core::Time(grid) : Core::Time());
 
-        friend Core::ThreadPool::JobType<Job&>;
-        void Dispatch()
-        {
-            TRACE(Trace::Information, (_T("Launcher: job is dispatched")));
-            // Let limit the jitter on the next run, if required..
-            Core::Time nextRun (Core::Time::Now());
+                return (grid != 0 ? Core::Time(grid + _splay) : Core::Time());
+            }
 
-             // Check if the process is not active, no need to reschedule the same job again.
-            if ( (_process.IsActive() == false) && (_shutdownCompleted.Lock(0) == Core::ERROR_NONE) ) {
+            const uint64_t interval = static_cast<uint64_t>(_interval.TimeInSeconds()) * Time::MilliSecondsPerSecond * Core::Time::TicksPerMillisecond;
+            const uint64_t start = _epoch.Ticks() + _splay;
 
-                ASSERT (_processList.size() == 0);
+            _tick++;
 
-                _processList.push_back(0);
-                _process.Launch(_options, &_processList.front());
+            if ((_catchUp != ALL) && ((start + (_tick * interval)) <= now.Ticks())) {
+                const uint64_t passed = (now.Ticks() - start) / interval;
 
-                TRACE(Trace::Information, (_T("Launched command: %s [%d]."), _options.Command().c_str(), Pid()));
-                ASSERT (_memory != nullptr);
+                // Run for the last one that was missed right away, or wait for the next one to come.
+                _tick = (_catchUp == ONCE ? passed : passed + 1);
+            }
 
-                _shutdownCompleted.Unlock();
+            return (Core::Time(start + (_tick * interval)));
+        }
+        // Called with a slot in the pool taken, it is given back once the whole tree is gone.
+        void Launch()
+        {
+            if (_shutdownCompleted.Lock(0) != Core::ERROR_NONE) {
+                _pool.Release();
             }
+            else {
+                // Only tracked once it runs, a resync should not conclude it before.
+                Instances launched;
+                launched.emplace_back(_process, _zygote);
+                Instance& instance(launched.back());
 
-            if (_interval.IsValid() == true) {
-                _adminLock.Lock();
-                if (_shutdownPhase == 0) {
-                    // Reschedule our next launch point...
-                    nextRun.Add(_interval.TimeInSeconds() * Time::MilliSecondsPerSecond);
-                    _job.Reschedule(nextRun);
+                if (_group.IsValid() == true) {
+                    // The group counts from its creation on, so only the growth belongs to this run.
+                    _group.Consumed(instance.Baseline);
                 }
+
+                _runs++;
+
+                const uint32_t result = instance.Process.Launch(_group.IsValid() == true ? &_group : nullptr, &instance.Pid);
+
+                _adminLock.Lock();
+                _pid = instance.Pid;
+                _respawning = false;
+                instance.Latency = (instance.Started > _dispatched ? static_cast<uint32_t>((instance.Started.Ticks() - _dispatched.Ticks()) / Core::Time::TicksPerMillisecond) : 0);
+                instance.Tree.insert(instance.Pid);
+                _instances.splice(_instances.end(), launched);
+                _processListEmpty.ResetEvent();
+                const bool populated = ((_group.IsValid() == false) || (_group.Populated() == true));
                 _adminLock.Unlock();
+
+                if (result != Core::ERROR_NONE) {
+                    // Nothing runs, so nothing will be reported, conclude this run right away.
+                    proc_event event;
+                    ::memset(&event, 0, sizeof(event));
+
+                    event.what = proc_event::PROC_EVENT_EXIT;
+                    event.event_data.exit.process_pid = _pid;
+                    event.event_data.exit.process_tgid = _pid;
+
+                    _owner->Update(ProcessObserver::Info(event));
+                }
+                else if (_observer != nullptr) {
+                    _memory->Add(_pid);
+                    _observer->Track(_pid, _owner);
+                }
+                else if (populated == false) {
+                    // The child moved itself into the group, but it might have left it already.
+                    _owner->Resync();
+                }
+
+                TRACE(Trace::Information, (_T("Launched command: %s [%d]."), _process.Command().c_str(), Pid()));
+                ASSERT (_memory != nullptr);
+
+                _shutdownCompleted.Unlock();
             }
         }
 
     private:
-        Core::CriticalSection _adminLock;
-        Core::Process::Options _options;
-        Core::Process _process;
-        Exchange::IMemory* _memory;
+        mutable Core::CriticalSection _adminLock;
+        ChildProcess _process;
+        Pool& _pool;
+        TimerWheel& _wheel;
+        PressureGate& _gate;
+        MemoryObserverImpl* _memory;
+        Zygote* _zygote;
+        ProcessObserver* _observer;
+        ProcessObserver::IProcessState* _owner;
+        ControlGroup _group;
+        string _cpuMax;
+        std::vector<string> _ioMax;
+        Capture _capture;
         Time _interval;
-        uint8_t _closeTime;
+        Cron _calendar;
+        Ladder _ladder;
+        uint8_t _step;
+        Core::Time _deadline;
+        uint8_t _priority;
+        catchup _catchUp;
+        overlap _overlap;
+        uint8_t _concurrency;
+        supervision _supervision;
+        uint32_t _backoff;
+        uint32_t _maxBackoff;
+        uint8_t _retries;
+        uint16_t _window;
+        uint32_t _delay;
+        std::list<Core::Time> _attempts;
+        bool _respawning;
+        uint32_t _respawns;
+        bool _critical;
+        Core::Time _deferredSince;
+        uint32_t _deferred;
+        uint64_t _splay;
+        Core::Time _due;
+        Core::Time _dispatched;
+        std::array<Outcome, HistorySize> _history;
+        uint32_t _recorded;
+        Usage _usage;
+        Core::Time _epoch;
+        uint64_t _tick;
         uint8_t _shutdownPhase;
-        ProcessList _processList;
+        uint32_t _pid;
+        uint32_t _runs;
+        bool _pending;
+        uint32_t _skipped;
+        uint32_t _restarted;
+        uint32_t _completed;
+        uint64_t _lastDuration;
+        uint64_t _maxDuration;
+        uint64_t _totalDuration;
+        Instances _instances;
+        Instances _finished;
         Core::Event _processListEmpty;
         Core::BinairySemaphore _shutdownCompleted;
 
+        Reaper _reaping;
         Core::WorkerPool::JobType<Job&> _job;
+        Core::WorkerPool::JobType<Reaper&> _reaper;
     };
 
 public:
@@ -736,23 +4961,32 @@ public:
 #pragma warning(disable : 4355)
 #endif
     Launcher()
-        : _service(nullptr)
+        : _adminLock()
+        , _service(nullptr)
         , _memory(nullptr)
         , _notification(this)
-        , _activity()
+        , _pool()
+        , _wheel()
+        , _gate()
+        , _zygote()
+        , _activities()
         , _deactivationInProgress()
+        , _observer(nullptr)
     {
+        RegisterAll();
     }
 #ifdef __WIN32__
 #pragma warning(default : 4355)
 #endif
     virtual ~Launcher()
     {
+        UnregisterAll();
     }
 
 public:
     BEGIN_INTERFACE_MAP(Launcher)
         INTERFACE_ENTRY(PluginHost::IPlugin)
+        INTERFACE_ENTRY(PluginHost::IDispatcher)
         INTERFACE_AGGREGATE(Exchange::IMemory, _memory)
     END_INTERFACE_MAP
 
@@ -778,17 +5012,44 @@ public:
     string Information() const override; 
 
 private:
+    // JSON-RPC methods
+    // -------------------------------------------------------------------------------------------------------
+    void RegisterAll();
+    void UnregisterAll();
+    uint32_t endpoint_status(Statistics& response);
+    uint32_t endpoint_output(const OutputData& parameters, OutputData& response);
+
+private:
+    typedef std::vector<Core::ProxyType<Job>> Activities;
+
+    static constexpr uint32_t FailureTail = 1024; // bytes, of the output logged on a failure
+    static constexpr uint32_t RequestTail = 16384; // bytes, of the output returned on request
+
     void Update(const ProcessObserver::Info& info);
-    bool ScheduleParameters(const Config& config, string& message, Core::Time& scheduleTime, Time& interval);
+    void Resync();
+    void Reap();
+    void Evaluate(Job& job);
+    void Cleanup();
+    void Status(Statistics& statistics) const;
+    bool ScheduleParameters(const Config::Schedule& schedule, string& message, Plan& plan);
+    bool ResourceParameters(const Config::Resources& resources, string& message, Plan& plan);
 
 private:
+    mutable Core::CriticalSection _adminLock;
     PluginHost::IShell* _service;
-    Exchange::IMemory* _memory;
+    MemoryObserverImpl* _memory;
     Core::SinkType<Notification> _notification;
-    Core::ProxyType<Job> _activity;
+    Pool _pool;
+    TimerWheel _wheel;
+    PressureGate _gate;
+    std::unique_ptr<Zygote> _zygote;
+    Activities _activities;
     bool _deactivationInProgress;
 
-    static ProcessObserver _observer;
+    ProcessObserver* _observer;
+
+    static ProcessObserver _netlinkObserver;
+    static ProcessObserver _pidfdObserver;
 };
 
 } //namespace Plugin
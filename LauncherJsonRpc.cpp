@@ -0,0 +1,71 @@
+#include "Launcher.h"
+
+namespace Thunder {
+
+namespace Plugin {
+
+    // Registration
+    //
+
+    void Launcher::RegisterAll()
+    {
+        Register<void, Statistics>(_T("status"), &Launcher::endpoint_status, this);
+        Register<OutputData, OutputData>(_T("output"), &Launcher::endpoint_output, this);
+    }
+
+    void Launcher::UnregisterAll()
+    {
+        Unregister(_T("status"));
+        Unregister(_T("output"));
+    }
+
+    // API implementation
+    //
+
+    // Method: status - The runs of all commands
+    // Return codes:
+    //  - ERROR_NONE: Success
+    uint32_t Launcher::endpoint_status(Statistics& response)
+    {
+        Status(response);
+
+        return (Core::ERROR_NONE);
+    }
+
+    // Method: output - The last output of a command
+    // Return codes:
+    //  - ERROR_NONE: Success
+    //  - ERROR_UNKNOWN_KEY: There is no command with this index
+    //  - ERROR_UNAVAILABLE: The output of the command is not captured
+    uint32_t Launcher::endpoint_output(const OutputData& parameters, OutputData& response)
+    {
+        uint32_t result = Core::ERROR_UNKNOWN_KEY;
+
+        _adminLock.Lock();
+
+        if (parameters.Index.Value() < _activities.size()) {
+            Job& job(*_activities[parameters.Index.Value()]);
+
+            if (job.Captured() == false) {
+                result = Core::ERROR_UNAVAILABLE;
+            }
+            else {
+                string output;
+
+                job.Tail(output, RequestTail);
+
+                response.Index = parameters.Index.Value();
+                response.Command = job.Command();
+                response.Output = output;
+                result = Core::ERROR_NONE;
+            }
+        }
+
+        _adminLock.Unlock();
+
+        return (result);
+    }
+
+} // namespace Plugin
+
+} // namespace Thunder
@@ -3,6 +3,11 @@
 #define MODULE_NAME Plugin_Launcher
 #endif
 
+// The helper that launches the commands in zygote mode, normally set by the build.
+#ifndef LAUNCHER_ZYGOTE
+#define LAUNCHER_ZYGOTE "LauncherZygote"
+#endif
+
 #include <plugins/plugins.h>
 #include <messaging/messaging.h>
 
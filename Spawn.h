@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Zygote.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace Thunder {
+namespace Plugin {
+
+    // Launches a command without copying the address space of the caller, which is big and has many
+    // threads. The child borrows the memory of the parent (vfork) until it executes the command, so
+    // the parent is suspended till then. If procs (cgroup.procs of a control group) is given, the child
+    // moves itself in there before it executes, so nothing it starts can escape from the group. The
+    // descriptor inherit is kept open for the command, its stdout and stderr are written to output.
+    //
+    // Returns the pid of the child, or -1 if there is none, error then holds the reason. If the child
+    // could not execute the command, error holds why and the child is reaped already.
+    inline pid_t Spawn(char* const arguments[], const int procs, const int inherit, const int output, const Scheduling& scheduling, int& error) {
+        sigset_t all, original;
+        volatile int failure = 0;
+
+        // No handler of the caller may run on the stack we share with the child.
+        ::sigfillset(&all);
+        ::pthread_sigmask(SIG_SETMASK, &all, &original);
+
+        const pid_t child = ::vfork();
+
+        if (child == 0) {
+            // From here on only async signal safe calls, we are running on the stack of the parent.
+            struct sigaction action;
+
+            for (int signal = 1; signal < NSIG; signal++) {
+                if ((::sigaction(signal, nullptr, &action) == 0) && (action.sa_handler != SIG_IGN) && (action.sa_handler != SIG_DFL)) {
+                    ::memset(&action, 0, sizeof(action));
+                    action.sa_handler = SIG_DFL;
+                    ::sigaction(signal, &action, nullptr);
+                }
+            }
+            ::pthread_sigmask(SIG_SETMASK, &original, nullptr);
+
+            if (inherit != -1) {
+                ::fcntl(inherit, F_SETFD, 0);
+            }
+            if (output != -1) {
+                ::dup2(output, STDOUT_FILENO);
+                ::dup2(output, STDERR_FILENO);
+            }
+
+            // A group of its own, so it can be signalled as a whole.
+            ::setpgid(0, 0);
+
+            if ((procs != -1) && (::write(procs, "0", 1) != 1)) {
+                failure = errno;
+            }
+            else {
+                // Within the bounds of the group, if there is one.
+                scheduling.Apply();
+                ::execvp(arguments[0], arguments);
+                failure = errno;
+            }
+            // As a shell reports a command it could not execute.
+            ::_exit(127);
+        }
+
+        error = (child == -1 ? errno : failure);
+
+        ::pthread_sigmask(SIG_SETMASK, &original, nullptr);
+
+        if ((child != -1) && (error != 0)) {
+            ::waitpid(child, nullptr, 0);
+        }
+
+        return (child);
+    }
+
+} // namespace Plugin
+} // namespace Thunder
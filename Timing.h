@@ -0,0 +1,291 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+namespace Thunder {
+namespace Plugin {
+namespace Timing {
+
+    // The schedule arithmetic, on plain ticks (microseconds since the epoch, in UTC), so it can be tested
+    // without the framework. All of it is UTC, a change of the daylight saving time does not move a run.
+
+    static constexpr uint64_t TicksPerSecond = 1000000;
+    static constexpr uint32_t SecondsPerMinute = 60;
+    static constexpr uint32_t SecondsPerHour = 60 * SecondsPerMinute;
+    static constexpr uint32_t SecondsPerDay = 24 * SecondsPerHour;
+
+    // A field of the time of day that is not given.
+    static constexpr int8_t Any = -1;
+
+    // RELATIVE, the given number of seconds from now.
+    inline uint64_t Relative(const uint64_t now, const uint32_t seconds) {
+        return (now + (static_cast<uint64_t>(seconds) * TicksPerSecond));
+    }
+
+    // The given time of today, the hours and minutes that are not given are those of now.
+    inline uint64_t Today(const uint64_t now, const int8_t hours, const int8_t minutes, const uint8_t seconds) {
+        const uint64_t day = (now / TicksPerSecond) / SecondsPerDay;
+        const uint32_t passed = static_cast<uint32_t>((now / TicksPerSecond) % SecondsPerDay);
+
+        return (((day * SecondsPerDay) +
+                 (static_cast<uint64_t>(hours != Any ? hours : passed / SecondsPerHour) * SecondsPerHour) +
+                 (static_cast<uint64_t>(minutes != Any ? minutes : (passed / SecondsPerMinute) % 60) * SecondsPerMinute) +
+                 seconds) * TicksPerSecond);
+    }
+
+    // ABSOLUTE, the given time of today. If that passed already, the next day if the hours are given,
+    // the next hour if only the minutes are given, or else the next minute.
+    inline uint64_t Absolute(const uint64_t now, const int8_t hours, const int8_t minutes, const uint8_t seconds) {
+        uint64_t result = Today(now, hours, minutes, seconds);
+
+        if (result < now) {
+            result += static_cast<uint64_t>(hours != Any ? SecondsPerDay : (minutes != Any ? SecondsPerHour : SecondsPerMinute)) * TicksPerSecond;
+        }
+
+        return (result);
+    }
+
+    // ABSOLUTE_WITH_INTERVAL, the first moment, not before now, on the grid of the interval (in seconds, not 0)
+    // through the given time of today.
+    inline uint64_t Aligned(const uint64_t now, const int8_t hours, const int8_t minutes, const uint8_t seconds, const uint32_t interval) {
+        const uint64_t jump = static_cast<uint64_t>(interval) * TicksPerSecond;
+        const uint64_t start = Today(now, hours, minutes, seconds);
+
+        // Go back as many whole intervals as possible, while staying after now, or go forward to the
+        // first interval that is not before now.
+        return (start >= now ? start - (((start - now) == 0 ? 0 : (start - now - 1) / jump) * jump)
+                             : start + ((((now - start) + jump - 1) / jump) * jump));
+    }
+
+    // A cron expression, "[second] minute hour day-of-month month day-of-week", compiled into a bitset per field.
+    // Each field is a comma separated list of "*", "N", "N-M", with an optional "/step".
+    class Cron {
+    private:
+        // Every day of the year, in every weekday, comes along in 28 years.
+        static constexpr int32_t MaxDays = 28 * 366;
+
+    public:
+        Cron()
+            : _seconds(0)
+            , _minutes(0)
+            , _hours(0)
+            , _days(0)
+            , _months(0)
+            , _weekdays(0)
+            , _anyDay(true)
+            , _anyWeekday(true) {
+        }
+        Cron(const Cron&) = default;
+        Cron& operator=(const Cron&) = default;
+        ~Cron() = default;
+
+    public:
+        bool IsValid() const {
+            return (_months != 0);
+        }
+        bool Parse(const std::string& expression) {
+            std::vector<std::string> fields;
+            std::string::size_type end = 0;
+
+            while ((end != std::string::npos) && (fields.size() <= 6)) {
+                const std::string::size_type start = expression.find_first_not_of(" \t", end);
+
+                if (start == std::string::npos) {
+                    end = std::string::npos;
+                }
+                else {
+                    end = expression.find_first_of(" \t", start);
+                    fields.push_back(expression.substr(start, end == std::string::npos ? end : end - start));
+                }
+            }
+
+            if (fields.size() == 5) {
+                fields.insert(fields.begin(), "0");
+            }
+
+            uint64_t weekdays = 0;
+
+            const bool parsed = ((fields.size() == 6) &&
+                                 (Field(fields[0], 0, 59, _seconds) == true) &&
+                                 (Field(fields[1], 0, 59, _minutes) == true) &&
+                                 (Field(fields[2], 0, 23, _hours) == true) &&
+                                 (Field(fields[3], 1, 31, _days) == true) &&
+                                 (Field(fields[4], 1, 12, _months) == true) &&
+                                 (Field(fields[5], 0, 7, weekdays) == true));
+
+            if (parsed == false) {
+                _months = 0;
+            }
+            else {
+                // Sunday is both 0 and 7, and if both days are restricted, either of them will do.
+                _weekdays = static_cast<uint8_t>((weekdays | (weekdays >> 7)) & 0x7F);
+                _anyDay = (fields[3][0] == '*');
+                _anyWeekday = (fields[5][0] == '*');
+            }
+
+            return (IsValid());
+        }
+        // The first whole second after the given moment that matches, 0 if there is none.
+        uint64_t Next(const uint64_t after) const {
+            uint64_t result = 0;
+            int32_t days = static_cast<int32_t>((after / TicksPerSecond) / SecondsPerDay);
+            uint32_t seconds = static_cast<uint32_t>((after / TicksPerSecond) % SecondsPerDay) + 1;
+            const int32_t last = days + MaxDays;
+
+            if (seconds == SecondsPerDay) {
+                seconds = 0;
+                days++;
+            }
+
+            while ((IsValid() == true) && (days < last) && (result == 0)) {
+                uint16_t year;
+                uint8_t month, day;
+
+                CivilFromDays(days, year, month, day);
+
+                if ((_months & (1 << month)) == 0) {
+                    // Skip the whole month.
+                    days += DaysInMonth(year, month) - day + 1;
+                }
+                else {
+                    if ((MatchesDay(day, static_cast<uint8_t>((days + 4) % 7)) == true) && (Within(seconds) == true)) {
+                        result = ((static_cast<uint64_t>(days) * SecondsPerDay) + seconds) * TicksPerSecond;
+                    }
+                    days++;
+                }
+                seconds = 0;
+            }
+
+            return (result);
+        }
+
+    private:
+        static bool Number(const std::string& text, uint32_t& value) {
+            bool result = ((text.empty() == false) && (text.length() <= 3) && (text.find_first_not_of("0123456789") == std::string::npos));
+
+            if (result == true) {
+                value = static_cast<uint32_t>(atoi(text.c_str()));
+            }
+            return (result);
+        }
+        static bool Field(const std::string& text, const uint32_t low, const uint32_t high, uint64_t& mask) {
+            bool result = true;
+            std::string::size_type start = 0;
+
+            mask = 0;
+
+            while ((result == true) && (start <= text.length())) {
+                std::string::size_type end = text.find(',', start);
+                const std::string item(text.substr(start, end == std::string::npos ? end : end - start));
+                const std::string::size_type slash = item.find('/');
+                const std::string range(item.substr(0, slash));
+                uint32_t from = low, to = high, step = 1;
+
+                if (slash != std::string::npos) {
+                    result = ((Number(item.substr(slash + 1), step) == true) && (step != 0));
+                }
+                if ((result == true) && (range != "*")) {
+                    const std::string::size_type dash = range.find('-');
+
+                    result = (Number(range.substr(0, dash), from) == true);
+
+                    if (dash != std::string::npos) {
+                        result = result && (Number(range.substr(dash + 1), to) == true);
+                    }
+                    else if (slash == std::string::npos) {
+                        to = from;
+                    }
+                }
+
+                result = result && (from >= low) && (to <= high) && (from <= to);
+
+                for (uint32_t value = from; (result == true) && (value <= to); value += step) {
+                    mask |= (1ULL << value);
+                }
+
+                start = (end == std::string::npos ? end : end + 1);
+            }
+
+            return (result);
+        }
+        // The first set bit, from the given one onwards, or -1.
+        static int8_t First(const uint64_t mask, const uint8_t from) {
+            const uint64_t remaining = (from < 64 ? (mask >> from) : 0);
+
+            return (remaining == 0 ? -1 : static_cast<int8_t>(from + __builtin_ctzll(remaining)));
+        }
+        bool MatchesDay(const uint8_t day, const uint8_t weekday) const {
+            const bool inMonth = ((_days & (1ULL << day)) != 0);
+            const bool inWeek = ((_weekdays & (1 << weekday)) != 0);
+
+            return ((_anyDay == true) || (_anyWeekday == true) ? (inMonth && inWeek) : (inMonth || inWeek));
+        }
+        // Moves the second of the day to the first one that matches, if there is one.
+        bool Within(uint32_t& seconds) const {
+            uint8_t hour = static_cast<uint8_t>(seconds / SecondsPerHour);
+            uint8_t minute = static_cast<uint8_t>((seconds / SecondsPerMinute) % 60);
+            uint8_t second = static_cast<uint8_t>(seconds % SecondsPerMinute);
+            int8_t h, m, s;
+
+            while ((h = First(_hours, hour)) >= 0) {
+                if (h != hour) {
+                    minute = 0;
+                    second = 0;
+                }
+                while ((m = First(_minutes, minute)) >= 0) {
+                    if (m != minute) {
+                        second = 0;
+                    }
+                    if ((s = First(_seconds, second)) >= 0) {
+                        seconds = (h * SecondsPerHour) + (m * SecondsPerMinute) + s;
+                        return (true);
+                    }
+                    minute = m + 1;
+                    second = 0;
+                }
+                hour = h + 1;
+                minute = 0;
+                second = 0;
+            }
+            return (false);
+        }
+        static bool IsLeap(const uint16_t year) {
+            return (((year % 4) == 0) && (((year % 100) != 0) || ((year % 400) == 0)));
+        }
+        static uint8_t DaysInMonth(const uint16_t year, const uint8_t month) {
+            static const uint8_t days[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+            return (((month == 2) && (IsLeap(year) == true)) ? 29 : days[month - 1]);
+        }
+        // Days since 1970-01-01, which was a Thursday.
+        static void CivilFromDays(int32_t days, uint16_t& year, uint8_t& month, uint8_t& day) {
+            days += 719468;
+
+            const int32_t era = (days >= 0 ? days : days - 146096) / 146097;
+            const uint32_t doe = static_cast<uint32_t>(days - (era * 146097));
+            const uint32_t yoe = (doe - (doe / 1460) + (doe / 36524) - (doe / 146096)) / 365;
+            const uint32_t doy = doe - ((365 * yoe) + (yoe / 4) - (yoe / 100));
+            const uint32_t mp = ((5 * doy) + 2) / 153;
+
+            day = static_cast<uint8_t>(doy - (((153 * mp) + 2) / 5) + 1);
+            month = static_cast<uint8_t>(mp < 10 ? mp + 3 : mp - 9);
+            year = static_cast<uint16_t>(static_cast<int32_t>(yoe) + (era * 400) + (month <= 2 ? 1 : 0));
+        }
+
+    private:
+        uint64_t _seconds;
+        uint64_t _minutes;
+        uint64_t _hours;
+        uint64_t _days;
+        uint64_t _months;
+        uint8_t _weekdays;
+        bool _anyDay;
+        bool _anyWeekday;
+    };
+
+} // namespace Timing
+} // namespace Plugin
+} // namespace Thunder
@@ -0,0 +1,222 @@
+// A small helper that launches the commands for the Launcher plugin. It is started once from the
+// plugin and forks a child for every launch request. As this process is tiny, forking it is cheap,
+// unlike forking the framework process itself.
+//
+// Usage: <zygote> <socket descriptor>
+
+#include "Zygote.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+using namespace Thunder::Plugin;
+
+static void Send(const int socket, const uint8_t command, const pid_t pid, const int32_t value, const struct rusage* usage = nullptr)
+{
+    uint8_t buffer[sizeof(ZygoteMessage) + sizeof(struct rusage)];
+    ZygoteMessage message;
+    size_t length = sizeof(message);
+
+    ::memset(&message, 0, sizeof(message));
+    message.Command = command;
+    message.Pid = pid;
+    message.Value = value;
+
+    ::memcpy(buffer, &message, sizeof(message));
+
+    if (usage != nullptr) {
+        ::memcpy(&(buffer[length]), usage, sizeof(struct rusage));
+        length += sizeof(struct rusage);
+    }
+
+    ::send(socket, buffer, length, MSG_NOSIGNAL);
+}
+
+static void Launch(const int socket, char buffer[], const size_t length, const sigset_t& original, const int output)
+{
+    std::vector<char*> arguments;
+    const char* end = &(buffer[length]);
+    char* current = &(buffer[sizeof(ZygoteMessage) + sizeof(Scheduling)]);
+    Scheduling scheduling;
+    std::string procs;
+    pid_t child = -1;
+    int32_t error = 0;
+    int report[2];
+
+    ::memcpy(&scheduling, &(buffer[sizeof(ZygoteMessage)]), sizeof(scheduling));
+
+    if (*current != '\0') {
+        procs = std::string(current) + "/cgroup.procs";
+    }
+    current += ::strlen(current) + 1;
+
+    while (current < end) {
+        arguments.push_back(current);
+        current += ::strlen(current) + 1;
+    }
+    arguments.push_back(nullptr);
+
+    if (arguments.size() < 2) {
+        error = EINVAL;
+    }
+    else if (::pipe2(report, O_CLOEXEC) != 0) {
+        error = errno;
+    }
+    else {
+        child = ::fork();
+
+        if (child == 0) {
+            int32_t result = 0;
+
+            ::sigprocmask(SIG_SETMASK, &original, nullptr);
+
+            // A process group of its own, so it can be signalled as a whole.
+            ::setpgid(0, 0);
+
+            if (output != -1) {
+                ::dup2(output, STDOUT_FILENO);
+                ::dup2(output, STDERR_FILENO);
+            }
+
+            // Move into the group before anything else can be started.
+            if (procs.empty() == false) {
+                int fd = ::open(procs.c_str(), O_WRONLY | O_CLOEXEC);
+
+                if ((fd == -1) || (::write(fd, "0", 1) != 1)) {
+                    result = errno;
+                }
+                if (fd != -1) {
+                    ::close(fd);
+                }
+            }
+            if (result == 0) {
+                scheduling.Apply();
+                ::execvp(arguments[0], arguments.data());
+                result = errno;
+            }
+
+            // Only gets here if it failed, report why.
+            if (::write(report[1], &result, sizeof(result)) != sizeof(result)) {
+                result = errno;
+            }
+            ::_exit(127);
+        }
+
+        ::close(report[1]);
+
+        if (child == -1) {
+            error = errno;
+        }
+        else if (::read(report[0], &error, sizeof(error)) == sizeof(error)) {
+            // Nothing is running, so do not report it as exited later on.
+            ::waitpid(child, nullptr, 0);
+        }
+        else {
+            // The pipe closed on the exec, so it is running.
+            error = 0;
+        }
+
+        ::close(report[0]);
+    }
+
+    Send(socket, ZygoteMessage::STARTED, child, error);
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 2) {
+        ::fprintf(stderr, "Usage: %s <socket descriptor>\n", argv[0]);
+        return (1);
+    }
+
+    const int socket = ::atoi(argv[1]);
+    char buffer[ZygoteMessage::MaxLength + 1];
+    sigset_t mask, original;
+
+    // The children should not inherit the connection with the plugin.
+    ::fcntl(socket, F_SETFD, FD_CLOEXEC);
+
+    ::sigemptyset(&mask);
+    ::sigaddset(&mask, SIGCHLD);
+    ::sigprocmask(SIG_BLOCK, &mask, &original);
+
+    const int children = ::signalfd(-1, &mask, SFD_CLOEXEC);
+    bool running = (children != -1);
+
+    while (running == true) {
+        struct pollfd descriptors[2] = { { socket, POLLIN, 0 }, { children, POLLIN, 0 } };
+
+        if (::poll(descriptors, 2, -1) < 0) {
+            running = (errno == EINTR);
+            continue;
+        }
+
+        if ((descriptors[1].revents & POLLIN) != 0) {
+            struct signalfd_siginfo info;
+            struct rusage usage;
+            pid_t pid;
+            int status;
+
+            if (::read(children, &info, sizeof(info)) == sizeof(info)) {
+                // Signals are merged, so collect everything that exited.
+                while ((pid = ::wait4(-1, &status, WNOHANG, &usage)) > 0) {
+                    Send(socket, ZygoteMessage::EXITED, pid, status, &usage);
+                }
+            }
+        }
+
+        if ((descriptors[0].revents & (POLLIN | POLLHUP | POLLERR)) != 0) {
+            struct iovec vector = { buffer, ZygoteMessage::MaxLength };
+            union {
+                struct cmsghdr header;
+                char buffer[CMSG_SPACE(sizeof(int))];
+            } control;
+            struct msghdr packet;
+            int output = -1;
+
+            ::memset(&packet, 0, sizeof(packet));
+            packet.msg_iov = &vector;
+            packet.msg_iovlen = 1;
+            packet.msg_control = control.buffer;
+            packet.msg_controllen = sizeof(control.buffer);
+
+            ssize_t length = ::recvmsg(socket, &packet, MSG_CMSG_CLOEXEC);
+
+            if (length > 0) {
+                struct cmsghdr* header = CMSG_FIRSTHDR(&packet);
+
+                if ((header != nullptr) && (header->cmsg_level == SOL_SOCKET) && (header->cmsg_type == SCM_RIGHTS) && (header->cmsg_len == CMSG_LEN(sizeof(int)))) {
+                    ::memcpy(&output, CMSG_DATA(header), sizeof(int));
+                }
+            }
+
+            if (length <= 0) {
+                // The plugin is gone, so are we.
+                running = false;
+            }
+            else if ((static_cast<size_t>(length) > (sizeof(ZygoteMessage) + sizeof(Scheduling))) && (reinterpret_cast<const ZygoteMessage*>(buffer)->Command == ZygoteMessage::LAUNCH)) {
+                buffer[length] = '\0';
+                Launch(socket, buffer, length, original, output);
+            }
+
+            // The child has its own copy by now.
+            if (output != -1) {
+                ::close(output);
+            }
+        }
+    }
+
+    return (0);
+}
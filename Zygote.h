@@ -0,0 +1,62 @@
+#pragma once
+
+#include <sched.h>
+#include <stdint.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace Thunder {
+namespace Plugin {
+
+    // The messages exchanged with the zygote helper over a SOCK_SEQPACKET socket, both ends run on
+    // the same host, so no need to worry about the byte order.
+    struct ZygoteMessage {
+        enum command : uint8_t {
+            // Launcher -> zygote, followed by the Scheduling, the control group (if any) and the arguments, all '\0' terminated.
+            // It can carry a descriptor (SCM_RIGHTS) the stdout and stderr of the command are written to.
+            LAUNCH = 1,
+            // Zygote -> Launcher, Value holds the errno if it could not be executed.
+            STARTED = 2,
+            // Zygote -> Launcher, Value holds the wait status, followed by the struct rusage of the child.
+            EXITED = 3
+        };
+
+        static constexpr uint32_t MaxLength = 8192;
+
+        uint8_t Command;
+        uint8_t Reserved[3];
+        int32_t Pid;
+        int32_t Value;
+    };
+
+    // How a command is scheduled, applied in the child just before it executes the command. Both the
+    // plugin and the zygote launch with it, so it only uses plain system calls.
+    struct Scheduling {
+        int32_t Policy; // SCHED_OTHER, SCHED_BATCH or SCHED_IDLE
+        int32_t Nice;
+        int32_t IoPriority; // As ioprio_set takes it, 0 leaves it as it is.
+        cpu_set_t Affinity; // Empty leaves it as it is.
+
+        // Best effort, what is not allowed is left as it is. Runs in a vforked child, so only async
+        // signal safe calls.
+        void Apply() const {
+            if (CPU_COUNT(&Affinity) > 0) {
+                ::sched_setaffinity(0, sizeof(Affinity), &Affinity);
+            }
+            if (Policy != SCHED_OTHER) {
+                struct sched_param parameters = {};
+                ::sched_setscheduler(0, Policy, &parameters);
+            }
+            if (Nice != 0) {
+                ::setpriority(PRIO_PROCESS, 0, Nice);
+            }
+            if (IoPriority != 0) {
+                // IOPRIO_WHO_PROCESS, there is no wrapper in libc.
+                ::syscall(SYS_ioprio_set, 1, 0, IoPriority);
+            }
+        }
+    };
+
+} // namespace Plugin
+} // namespace Thunder
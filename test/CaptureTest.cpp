@@ -0,0 +1,97 @@
+// The capture of the output of the commands, see Launcher::Capture. Needs the framework, for the resource
+// monitor that drains the pipe.
+
+#include "../Launcher.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace Thunder;
+
+namespace {
+
+    uint32_t failures = 0;
+
+    void Check(const char* name, const string& result, const string& expected) {
+        if (result != expected) {
+            ::printf("FAILED %s: \"%s\", expected \"%s\"\n", name, result.c_str(), expected.c_str());
+            failures++;
+        }
+    }
+
+    void Write(Plugin::Launcher::Capture& capture, const string& text) {
+        if (::write(capture.Sink(), text.c_str(), text.length()) != static_cast<ssize_t>(text.length())) {
+            ::printf("FAILED writing to the capture\n");
+            failures++;
+        }
+    }
+
+    string Tail(Plugin::Launcher::Capture& capture, const uint32_t length) {
+        string result;
+        capture.Tail(result, length);
+        return (result);
+    }
+
+    void Buffer() {
+        Plugin::Launcher::Capture capture(8, string(), 0, 0);
+
+        capture.Open();
+        Write(capture, _T("hello"));
+        Check("buffer", Tail(capture, 64), _T("hello"));
+        Write(capture, _T(" world"));
+        Check("buffer wrapped", Tail(capture, 64), _T("lo world"));
+        Check("buffer shorter", Tail(capture, 3), _T("rld"));
+        capture.Close();
+    }
+
+    void File(const string& directory) {
+        const string file(directory + _T("/output.log"));
+        Plugin::Launcher::Capture capture(0, file, 0, 0);
+
+        capture.Open();
+        Write(capture, _T("hello"));
+        Check("file", Tail(capture, 64), _T("hello"));
+        Write(capture, _T(" world"));
+        Check("file shorter", Tail(capture, 5), _T("world"));
+        capture.Close();
+
+        ::unlink(file.c_str());
+    }
+
+    void Rotated(const string& directory) {
+        const string file(directory + _T("/rotated.log"));
+        Plugin::Launcher::Capture capture(0, file, 8, 1);
+
+        capture.Open();
+        Write(capture, _T("0123456789"));
+        Check("rotated, all in the previous", Tail(capture, 4), _T("6789"));
+        Write(capture, _T("ab"));
+        Check("rotated, over both", Tail(capture, 6), _T("6789ab"));
+        capture.Close();
+
+        ::unlink(file.c_str());
+        ::unlink((file + _T(".1")).c_str());
+    }
+
+} // namespace
+
+int main() {
+    char directory[] = "/tmp/LauncherCaptureXXXXXX";
+
+    if (::mkdtemp(directory) == nullptr) {
+        ::printf("FAILED creating %s\n", directory);
+        failures++;
+    }
+    else {
+        Buffer();
+        File(directory);
+        Rotated(directory);
+
+        ::rmdir(directory);
+    }
+
+    Core::Singleton::Dispose();
+
+    return (failures == 0 ? 0 : 1);
+}
@@ -0,0 +1,144 @@
+// The arithmetic of the schedule modes, see Timing.h. Without the framework, so it runs anywhere.
+
+#include "../Timing.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+using namespace Thunder::Plugin;
+
+namespace {
+
+    uint32_t failures = 0;
+
+    uint64_t At(const int year, const int month, const int day, const int hour, const int minute, const int second, const uint32_t micro = 0) {
+        struct tm moment = {};
+
+        moment.tm_year = year - 1900;
+        moment.tm_mon = month - 1;
+        moment.tm_mday = day;
+        moment.tm_hour = hour;
+        moment.tm_min = minute;
+        moment.tm_sec = second;
+
+        return ((static_cast<uint64_t>(::timegm(&moment)) * Timing::TicksPerSecond) + micro);
+    }
+
+    void Check(const char* name, const uint64_t result, const uint64_t expected) {
+        if (result != expected) {
+            const time_t seconds[2] = { static_cast<time_t>(result / Timing::TicksPerSecond), static_cast<time_t>(expected / Timing::TicksPerSecond) };
+            char text[2][32];
+
+            for (uint8_t index = 0; index < 2; index++) {
+                struct tm moment;
+                ::gmtime_r(&(seconds[index]), &moment);
+                ::strftime(text[index], sizeof(text[index]), "%Y-%m-%d %H:%M:%S", &moment);
+            }
+
+            ::printf("FAILED %s: %s, expected %s\n", name, text[0], text[1]);
+            failures++;
+        }
+    }
+
+    void Relative() {
+        Check("relative", Timing::Relative(At(2026, 3, 28, 10, 0, 0), 90), At(2026, 3, 28, 10, 1, 30));
+        Check("relative over midnight", Timing::Relative(At(2026, 12, 31, 23, 59, 30), 45), At(2027, 1, 1, 0, 0, 15));
+    }
+
+    void Absolute() {
+        Check("absolute later today", Timing::Absolute(At(2026, 3, 28, 9, 0, 0), 10, 30, 0), At(2026, 3, 28, 10, 30, 0));
+        Check("absolute passed", Timing::Absolute(At(2026, 3, 28, 11, 0, 0), 10, 30, 0), At(2026, 3, 29, 10, 30, 0));
+        Check("absolute now", Timing::Absolute(At(2026, 3, 28, 10, 30, 0), 10, 30, 0), At(2026, 3, 28, 10, 30, 0));
+        Check("absolute just passed", Timing::Absolute(At(2026, 3, 28, 10, 30, 0, 1), 10, 30, 0), At(2026, 3, 29, 10, 30, 0));
+        Check("absolute last second", Timing::Absolute(At(2026, 12, 31, 23, 59, 59, 500000), 23, 59, 59), At(2027, 1, 1, 23, 59, 59));
+        Check("absolute midnight", Timing::Absolute(At(2026, 3, 28, 23, 0, 0), 0, 0, 0), At(2026, 3, 29, 0, 0, 0));
+        Check("absolute leap day", Timing::Absolute(At(2028, 2, 28, 23, 0, 0), 22, 0, 0), At(2028, 2, 29, 22, 0, 0));
+        Check("absolute minutes", Timing::Absolute(At(2026, 3, 28, 10, 20, 0), Timing::Any, 15, 0), At(2026, 3, 28, 11, 15, 0));
+        Check("absolute minutes over midnight", Timing::Absolute(At(2026, 3, 28, 23, 20, 0), Timing::Any, 15, 0), At(2026, 3, 29, 0, 15, 0));
+        Check("absolute seconds over midnight", Timing::Absolute(At(2026, 3, 28, 23, 59, 45), Timing::Any, Timing::Any, 30), At(2026, 3, 29, 0, 0, 30));
+    }
+
+    void Aligned() {
+        Check("interval next hour", Timing::Aligned(At(2026, 3, 28, 10, 20, 0), 0, 0, 0, 3600), At(2026, 3, 28, 11, 0, 0));
+        Check("interval back from tonight", Timing::Aligned(At(2026, 3, 28, 0, 10, 0), 23, 30, 0, 3600), At(2026, 3, 28, 0, 30, 0));
+        Check("interval on the grid", Timing::Aligned(At(2026, 3, 28, 10, 0, 0), 0, 0, 0, 3600), At(2026, 3, 28, 10, 0, 0));
+        Check("interval on the start", Timing::Aligned(At(2026, 3, 28, 23, 30, 0), 23, 30, 0, 3600), At(2026, 3, 28, 23, 30, 0));
+        Check("interval odd", Timing::Aligned(At(2026, 3, 28, 12, 0, 1), 12, 0, 0, 7), At(2026, 3, 28, 12, 0, 7));
+        Check("interval over midnight", Timing::Aligned(At(2026, 3, 28, 23, 50, 0), 0, 0, 0, 45 * 60), At(2026, 3, 29, 0, 0, 0));
+        Check("interval minutes", Timing::Aligned(At(2026, 3, 28, 10, 20, 0), Timing::Any, 5, 0, 600), At(2026, 3, 28, 10, 25, 0));
+    }
+
+    void Cron() {
+        Timing::Cron calendar;
+
+        Check("cron parse", calendar.Parse("0 0 * * *"), true);
+        Check("cron midnight", calendar.Next(At(2026, 3, 28, 23, 59, 59, 999999)), At(2026, 3, 29, 0, 0, 0));
+        Check("cron not the same second", calendar.Next(At(2026, 3, 29, 0, 0, 0)), At(2026, 3, 30, 0, 0, 0));
+        Check("cron year end", calendar.Next(At(2026, 12, 31, 12, 0, 0)), At(2027, 1, 1, 0, 0, 0));
+
+        calendar.Parse("*/15 * * * *");
+        Check("cron step", calendar.Next(At(2026, 3, 28, 10, 7, 30)), At(2026, 3, 28, 10, 15, 0));
+        Check("cron step over midnight", calendar.Next(At(2026, 3, 28, 23, 45, 0)), At(2026, 3, 29, 0, 0, 0));
+
+        calendar.Parse("30 * * * * *");
+        Check("cron seconds", calendar.Next(At(2026, 3, 28, 10, 0, 30)), At(2026, 3, 28, 10, 1, 30));
+
+        calendar.Parse("0 12 29 2 *");
+        Check("cron leap day", calendar.Next(At(2026, 3, 1, 0, 0, 0)), At(2028, 2, 29, 12, 0, 0));
+
+        // 2026-10-17 is a Saturday.
+        calendar.Parse("0 9 * * 1");
+        Check("cron weekday", calendar.Next(At(2026, 10, 17, 12, 0, 0)), At(2026, 10, 19, 9, 0, 0));
+        calendar.Parse("0 0 13 * 5");
+        Check("cron day or weekday", calendar.Next(At(2026, 10, 17, 12, 0, 0)), At(2026, 10, 23, 0, 0, 0));
+        calendar.Parse("0 0 * * 7");
+        Check("cron sunday is 7", calendar.Next(At(2026, 10, 17, 12, 0, 0)), At(2026, 10, 18, 0, 0, 0));
+
+        calendar.Parse("0 0 31 2 *");
+        Check("cron never", calendar.Next(At(2026, 3, 1, 0, 0, 0)), 0);
+
+        Check("cron out of range", calendar.Parse("61 * * * *"), false);
+        Check("cron too few fields", calendar.Parse("* * *"), false);
+        Check("cron bad step", calendar.Parse("*/0 * * * *"), false);
+    }
+
+    // In Europe the clock moves forward at 2026-03-29 01:00 UTC and back at 2026-10-25 01:00 UTC. The
+    // schedule is UTC, so the local time zone does not matter, and the runs stay a whole day (or interval)
+    // apart, also over these changes.
+    void DaylightSaving() {
+        const char* zones[] = { "UTC", "Europe/Amsterdam", "America/New_York" };
+
+        for (const char* zone : zones) {
+            ::setenv("TZ", zone, 1);
+            ::tzset();
+
+            const uint64_t before = Timing::Absolute(At(2026, 3, 28, 3, 0, 0), 2, 30, 0);
+            const uint64_t after = Timing::Absolute(before, 2, 30, 0);
+
+            Check("dst absolute", before, At(2026, 3, 29, 2, 30, 0));
+            Check("dst absolute same day", after, before);
+            Check("dst absolute next day", Timing::Absolute(before + 1, 2, 30, 0), before + (Timing::SecondsPerDay * Timing::TicksPerSecond));
+
+            Check("dst interval", Timing::Aligned(At(2026, 10, 25, 0, 30, 0), 0, 0, 0, 3600), At(2026, 10, 25, 1, 0, 0));
+            Check("dst interval next", Timing::Aligned(At(2026, 10, 25, 1, 0, 0, 1), 0, 0, 0, 3600), At(2026, 10, 25, 2, 0, 0));
+
+            Timing::Cron calendar;
+            calendar.Parse("0 30 2 * * *");
+            Check("dst cron", calendar.Next(At(2026, 3, 28, 3, 0, 0)), At(2026, 3, 29, 2, 30, 0));
+        }
+    }
+
+}
+
+int main() {
+    Relative();
+    Absolute();
+    Aligned();
+    Cron();
+    DaylightSaving();
+
+    ::printf("%s\n", (failures == 0 ? "All schedule tests passed." : "Schedule tests failed."));
+
+    return (failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -0,0 +1,209 @@
+// The time it takes to stop the commands of a plugin, all at the same time as Deinitialize does, and one after
+// the other as it was done before. Needs the framework. Arguments: [commands] [closetime in s], every command
+// ignores SIGTERM, so it is only gone once it is killed after the closetime. It fails if a command is left.
+
+#include "../Launcher.h"
+
+using namespace Thunder;
+
+namespace {
+
+    typedef Plugin::Launcher Launcher;
+    typedef std::vector<Core::ProxyType<Launcher::Job>> Jobs;
+
+    class WorkerPoolImplementation : public Core::WorkerPool {
+    private:
+        class Dispatcher : public Core::ThreadPool::IDispatcher {
+        public:
+            Dispatcher(const Dispatcher&) = delete;
+            Dispatcher& operator=(const Dispatcher&) = delete;
+
+            Dispatcher() = default;
+            ~Dispatcher() override = default;
+
+        private:
+            void Initialize() override {
+            }
+            void Deinitialize() override {
+            }
+            void Dispatch(Core::IDispatch* job) override {
+                job->Dispatch();
+            }
+        };
+
+    public:
+        WorkerPoolImplementation() = delete;
+        WorkerPoolImplementation(const WorkerPoolImplementation&) = delete;
+        WorkerPoolImplementation& operator=(const WorkerPoolImplementation&) = delete;
+
+        WorkerPoolImplementation(const uint8_t threads, const uint32_t queueSize)
+            : Core::WorkerPool(threads, 0, queueSize, &_dispatch, nullptr)
+            , _dispatch()
+        {
+            Run();
+        }
+        ~WorkerPoolImplementation() override
+        {
+            Stop();
+        }
+
+    private:
+        Dispatcher _dispatch;
+    };
+
+    // Hands the process events to the jobs, as the plugin does.
+    class Owner : public Launcher::ProcessObserver::IProcessState {
+    public:
+        Owner() = delete;
+        Owner(const Owner&) = delete;
+        Owner& operator=(const Owner&) = delete;
+
+        explicit Owner(Jobs& jobs)
+            : _jobs(jobs)
+        {
+        }
+        ~Owner() override = default;
+
+    public:
+        void Update(const Launcher::ProcessObserver::Info& info) override {
+            for (Core::ProxyType<Launcher::Job>& job : _jobs) {
+                if ((job->IsActive() == true) && (job->Update(info) == true)) {
+                    job->ExitCode();
+                    break;
+                }
+            }
+        }
+        void Resync() override {
+            for (Core::ProxyType<Launcher::Job>& job : _jobs) {
+                if (job->IsActive() == true) {
+                    job->Resync();
+                    job->ExitCode();
+                }
+            }
+        }
+        void Reap() override {
+            for (Core::ProxyType<Launcher::Job>& job : _jobs) {
+                if (job->Reaping() == true) {
+                    job->ExitCode();
+                }
+            }
+        }
+
+    private:
+        Jobs& _jobs;
+    };
+
+    // Launches the commands, stops them and returns how long that took, in ms.
+    uint64_t Stop(const Launcher::Config& config, const Launcher::Config::Entry& entry, const uint32_t commands, const bool parallel, uint32_t& failures) {
+        Launcher::MemoryObserverImpl* memory = Core::ServiceType<Launcher::MemoryObserverImpl>::Create<Launcher::MemoryObserverImpl>();
+        Launcher::ProcessObserver observer(Launcher::PIDFD);
+        Launcher::Pool pool;
+        Launcher::TimerWheel wheel;
+        Launcher::PressureGate gate;
+        Launcher::Plan plan;
+        Jobs jobs;
+        Owner owner(jobs);
+
+        const Launcher::Context context { config, pool, wheel, gate, memory, nullptr, &observer, &owner };
+
+        plan.Start = Core::Time::Now();
+        pool.Open(0, Launcher::FIFO);
+
+        for (uint32_t index = 0; index < commands; index++) {
+            jobs.push_back(Core::ProxyType<Launcher::Job>::Create(context, entry, plan, string()));
+            jobs.back()->Open();
+        }
+
+        observer.Register(&owner);
+
+        for (Core::ProxyType<Launcher::Job>& job : jobs) {
+            job->Schedule(plan.Start);
+        }
+
+        // Till all of them run, and the children are found, the observer polls for them.
+        for (uint32_t waiting = 0; (waiting < 100) && (std::any_of(jobs.begin(), jobs.end(), [](const Core::ProxyType<Launcher::Job>& job) { return (job->IsActive() == false); }) == true); waiting++) {
+            SleepMs(10);
+        }
+        SleepMs(500);
+
+        const Core::Time start(Core::Time::Now());
+
+        if (parallel == true) {
+            Core::Time deadline;
+
+            for (Core::ProxyType<Launcher::Job>& job : jobs) {
+                const Core::Time completed(job->Terminate());
+
+                if (completed > deadline) {
+                    deadline = completed;
+                }
+            }
+            for (Core::ProxyType<Launcher::Job>& job : jobs) {
+                job->Wait(deadline);
+            }
+        }
+        else {
+            for (Core::ProxyType<Launcher::Job>& job : jobs) {
+                job->Wait(job->Terminate());
+            }
+        }
+
+        const uint64_t result = (Core::Time::Now().Ticks() - start.Ticks()) / Core::Time::TicksPerMillisecond;
+
+        for (Core::ProxyType<Launcher::Job>& job : jobs) {
+            if (job->IsActive() == true) {
+                ::printf("FAILED %s is still running [%d]\n", job->Command().c_str(), job->Pid());
+                failures++;
+            }
+        }
+
+        observer.Unregister(&owner);
+
+        for (Core::ProxyType<Launcher::Job>& job : jobs) {
+            job->Close();
+        }
+
+        jobs.clear();
+        pool.Close();
+        wheel.Close();
+
+        memory->Stop();
+        memory->Release();
+
+        return (result);
+    }
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const uint32_t commands = (argc > 1 ? static_cast<uint32_t>(::atoi(argv[1])) : 20);
+    const uint8_t closeTime = (argc > 2 ? static_cast<uint8_t>(::atoi(argv[2])) : 2);
+    uint32_t failures = 0;
+
+    {
+        WorkerPoolImplementation workerPool(4, 64);
+        Launcher::Config config;
+        Launcher::Config::Entry entry;
+
+        Core::WorkerPool::Assign(&workerPool);
+
+        config.CloseTime = closeTime;
+        entry.Command = _T("sh");
+
+        Launcher::Config::Parameter& parameter(entry.Parameters.Add());
+        parameter.Option = _T("-c");
+        parameter.Value = _T("exec 2>/dev/null; trap '' TERM; sleep 60");
+
+        const uint64_t parallel = Stop(config, entry, commands, true, failures);
+        const uint64_t serial = Stop(config, entry, commands, false, failures);
+
+        ::printf("%u commands, closetime %u s, stopped at once: %llu ms, one after the other: %llu ms\n", commands, closeTime,
+            static_cast<unsigned long long>(parallel), static_cast<unsigned long long>(serial));
+
+        Core::WorkerPool::Assign(nullptr);
+    }
+
+    Core::Singleton::Dispose();
+
+    return (failures == 0 ? 0 : 1);
+}
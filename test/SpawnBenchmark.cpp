@@ -0,0 +1,108 @@
+// The time it takes to launch a command from a big host, with Spawn (see Spawn.h) and with fork. Without the
+// framework, so it runs anywhere. Arguments: [launches] [megabytes of the host], it fails if Spawn does not
+// report the exit or the error of the command.
+
+#include "../Spawn.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+using namespace Thunder::Plugin;
+
+namespace {
+
+    uint64_t Now() {
+        struct timespec now;
+
+        ::clock_gettime(CLOCK_MONOTONIC, &now);
+
+        return ((static_cast<uint64_t>(now.tv_sec) * 1000000) + (now.tv_nsec / 1000));
+    }
+
+    int Status(const pid_t child) {
+        int status = 0;
+
+        ::waitpid(child, &status, 0);
+
+        return (WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+    }
+
+    pid_t Fork(char* const arguments[]) {
+        const pid_t child = ::fork();
+
+        if (child == 0) {
+            ::execvp(arguments[0], arguments);
+            ::_exit(127);
+        }
+
+        return (child);
+    }
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const uint32_t launches = (argc > 1 ? static_cast<uint32_t>(::atoi(argv[1])) : 200);
+    const size_t megabytes = (argc > 2 ? static_cast<size_t>(::atoi(argv[2])) : 256);
+    const Scheduling scheduling = {};
+    uint32_t failures = 0;
+    int error = 0;
+
+    // The pages of the host have to be mapped, fork copies their tables.
+    char* host = static_cast<char*>(::malloc(megabytes << 20));
+    ::memset(host, 1, megabytes << 20);
+
+    char command[] = "sh";
+    char option[] = "-c";
+    char script[] = "exit 3";
+    char* const shell[] = { command, option, script, nullptr };
+
+    pid_t child = Spawn(shell, -1, -1, -1, scheduling, error);
+
+    if ((child == -1) || (error != 0) || (Status(child) != 3)) {
+        ::printf("FAILED exit code of the command\n");
+        failures++;
+    }
+
+    char missing[] = "/nonexistent/command";
+    char* const nothing[] = { missing, nullptr };
+
+    child = Spawn(nothing, -1, -1, -1, scheduling, error);
+
+    if ((child == -1) || (error != ENOENT)) {
+        ::printf("FAILED error of a command that does not exist: %d\n", error);
+        failures++;
+    }
+
+    char truth[] = "true";
+    char* const empty[] = { truth, nullptr };
+    uint64_t spawned = 0, forked = 0;
+
+    for (uint32_t index = 0; index < launches; index++) {
+        uint64_t start = Now();
+        child = Spawn(empty, -1, -1, -1, scheduling, error);
+        spawned += Now() - start;
+
+        if ((child == -1) || (error != 0) || (Status(child) != 0)) {
+            failures++;
+        }
+
+        start = Now();
+        child = Fork(empty);
+        forked += Now() - start;
+
+        if ((child == -1) || (Status(child) != 0)) {
+            failures++;
+        }
+    }
+
+    if (launches != 0) {
+        ::printf("%u launches from a host of %zu MB, spawn: %llu us, fork: %llu us\n", launches, megabytes,
+            static_cast<unsigned long long>(spawned / launches), static_cast<unsigned long long>(forked / launches));
+    }
+
+    ::free(host);
+
+    return (failures == 0 ? 0 : 1);
+}